@@ -1,2 +1,3 @@
+# any extra arguments are passed to every process, e.g. ./2players.sh --latency 50 --jitter 10 --loss 2
 make -j12 -s all
-(./bin/Debug/TrollsVsElves server) && sleep 1 & ./bin/Debug/TrollsVsElves client & ./bin/Debug/TrollsVsElves client
\ No newline at end of file
+(./bin/Debug/TrollsVsElves server "$@") && sleep 1 & ./bin/Debug/TrollsVsElves client "$@" & ./bin/Debug/TrollsVsElves client "$@"
@@ -0,0 +1,38 @@
+baseName = path.getbasename(os.getcwd());
+
+project (baseName)
+    kind "ConsoleApp"
+    location "./"
+    targetdir "../bin/%{cfg.buildcfg}"
+
+    filter "action:vs*"
+        debugdir "$(SolutionDir)"
+
+    filter{}
+
+    vpaths
+    {
+        ["Header Files/*"] = { "include/**.h",  "include/**.hpp", "src/**.h", "src/**.hpp", "**.h", "**.hpp"},
+        ["Source Files/*"] = {"src/**.c", "src/**.cpp","**.c", "**.cpp"},
+    }
+    files {"src/**.cpp", "src/**.h"}
+
+    -- the json loaders are compiled straight from the game so the bundle always matches what the game would parse
+    files {
+        "../TrollsVsElves/src/ActionsManager.cpp",
+        "../TrollsVsElves/src/GameDataBundle.cpp",
+        "../TrollsVsElves/src/MapGenerator.cpp",
+        "../TrollsVsElves/src/TiledMapReader.cpp",
+        "../TrollsVsElves/src/JobSystem.cpp",
+        "../TrollsVsElves/src/FrameArena.cpp",
+        "../TrollsVsElves/src/PathFinding.cpp",
+        "../TrollsVsElves/src/ConnectedComponents.cpp",
+        "../TrollsVsElves/src/Profiler.cpp",
+        "../TrollsVsElves/src/Logger.cpp",
+    }
+
+    includedirs { "./", "src", "../TrollsVsElves/include" }
+    links { "pthread", "z" }
+
+    link_raylib()
+    link_to("jsoncpp")
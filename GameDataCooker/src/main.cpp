@@ -0,0 +1,167 @@
+#include "ActionsManager.h"
+#include "GameDataBundle.h"
+#include "MapGenerator.h"
+#include "Logger.h"
+#include "constants.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Converts the json game data into the binary bundle the game loads at startup, see GameDataBundle.h.
+// Run from the repository root whenever actions.json, requirements.json or a map changes, e.g.
+//     ./bin/Release/GameDataCooker
+//     ./bin/Release/GameDataCooker --output gamedata.bin map/map.json map/smol.json
+// The game falls back to the json files for anything changed after the bundle was cooked
+
+struct BundleWriter
+{
+    std::vector<char> bytes;
+    std::string strings;
+
+    size_t align()
+    {
+        bytes.resize((bytes.size() + 7) & ~size_t(7), 0);
+        return bytes.size();
+    }
+
+    size_t write(const void* source, size_t size)
+    {
+        size_t offset = bytes.size();
+        bytes.insert(bytes.end(), (const char*)source, (const char*)source + size);
+        return offset;
+    }
+
+    template<typename T>
+    size_t writeArray(const std::vector<T>& values)
+    {
+        size_t offset = align();
+        write(values.data(), values.size() * sizeof(T));
+        return offset;
+    }
+
+    BundleString addString(const std::string& string)
+    {
+        BundleString bundleString = { uint32_t(strings.size()), uint32_t(string.size()) };
+        strings += string;
+        return bundleString;
+    }
+};
+
+bool cook(std::string outputFilename, std::string requirementsFilename, std::string actionsFilename, std::vector<std::string> mapFilenames)
+{
+    ActionsManager& actionsManager = ActionsManager::get();
+    actionsManager.load(requirementsFilename, actionsFilename);
+
+    BundleWriter writer;
+    BundleHeader header = {};
+    memcpy(header.magic, "TVEB", 4);
+    header.version = GAME_DATA_BUNDLE_VERSION;
+    header.endianness = GAME_DATA_BUNDLE_ENDIANNESS;
+    header.maxActions = MAX_ACTIONS;
+    writer.write(&header, sizeof(header)); // placeholder, rewritten once the offsets are known
+
+    // actions, indexed by ActionId
+    std::vector<BundleAction> actions;
+    std::vector<uint32_t> childOffsets;
+    std::vector<ActionId> children;
+    std::vector<uint64_t> requirements;
+    for (ActionId id = 0; id < actionsManager.size(); id++)
+    {
+        const ActionNode& node = actionsManager.getNode(id);
+        actions.push_back({ writer.addString(node.key), writer.addString(node.name), uint32_t(node.type) });
+
+        childOffsets.push_back(children.size());
+        for (const ActionNode& child: actionsManager.getActionChildren(id))
+            children.push_back(child.id);
+
+        const ActionSet& required = actionsManager.getRequirements(id);
+        for (size_t word = 0; word < MAX_ACTIONS / 64; word++)
+        {
+            uint64_t bits = 0;
+            for (size_t bit = 0; bit < 64; bit++)
+                if (required.test(word * 64 + bit))
+                    bits |= uint64_t(1) << bit;
+            requirements.push_back(bits);
+        }
+    }
+    childOffsets.push_back(children.size());
+
+    header.nrOfActions = actions.size();
+    header.nrOfChildren = children.size();
+    header.actionsOffset = writer.writeArray(actions);
+    header.childOffsetsOffset = writer.writeArray(childOffsets);
+    header.childrenOffset = writer.writeArray(children);
+    header.requirementsOffset = writer.writeArray(requirements);
+
+    // maps, the tiles first so the table can point at them
+    std::vector<BundleMap> maps;
+    for (const std::string& mapFilename: mapFilenames)
+    {
+        std::shared_ptr<const MapTemplate> mapTemplate = MapTemplateCache::get().load(mapFilename);
+        size_t nrOfTiles = size_t(mapTemplate->nrOfLayers) * mapTemplate->gridSize.x * mapTemplate->gridSize.y;
+
+        BundleMap map = {};
+        map.filename = writer.addString(mapFilename);
+        map.width = mapTemplate->gridSize.x;
+        map.height = mapTemplate->gridSize.y;
+        map.nrOfLayers = mapTemplate->nrOfLayers;
+        map.tilesOffset = writer.align();
+        writer.write(mapTemplate->tiles, nrOfTiles * sizeof(int32_t));
+        maps.push_back(map);
+    }
+
+    header.nrOfMaps = maps.size();
+    header.mapsOffset = writer.writeArray(maps);
+
+    header.stringsOffset = writer.align();
+    header.stringsSize = writer.strings.size();
+    writer.write(writer.strings.data(), writer.strings.size());
+    writer.align();
+
+    header.fileSize = writer.bytes.size();
+    memcpy(writer.bytes.data(), &header, sizeof(header));
+
+    std::ofstream file(outputFilename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        LOG_ERROR("could not open %s for writing", outputFilename.c_str());
+        return false;
+    }
+    file.write(writer.bytes.data(), writer.bytes.size());
+    file.close();
+
+    LOG_INFO("cooked %u actions and %u maps into %s (%zu bytes)", header.nrOfActions, header.nrOfMaps, outputFilename.c_str(), writer.bytes.size());
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string outputFilename = constants::GAME_DATA_BUNDLE_FILENAME;
+    std::string requirementsFilename = "requirements.json";
+    std::string actionsFilename = "actions.json";
+    std::vector<std::string> mapFilenames;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--output" && hasValue)              outputFilename = argv[++i];
+        else if (arg == "--requirements" && hasValue)   requirementsFilename = argv[++i];
+        else if (arg == "--actions" && hasValue)        actionsFilename = argv[++i];
+        else if (arg.rfind("--", 0) != 0)               mapFilenames.push_back(arg);
+        else
+        {
+            printf("usage: GameDataCooker [--output file] [--requirements file] [--actions file] [map files...]\n");
+            return 1;
+        }
+    }
+
+    if (mapFilenames.empty())
+        mapFilenames.push_back("map/map.json");
+
+    bool cooked = cook(outputFilename, requirementsFilename, actionsFilename, mapFilenames);
+    Logger::get().flush();
+    return cooked ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+#include "PathFinding.h"
+#include "AllocationCounter.h"
+#include "FrameArena.h"
+#include "MapGenerator.h"
+#include "ConnectedComponents.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// Runs fixed, seeded query sets through every pathfinding backend and prints one json object per
+// (map, backend) pair on stdout, so results can be diffed or fed to a script between commits.
+// Run from the repository root so the map/ folder can be found, e.g.
+//     ./bin/Release/PathfindingBench > bench_output.txt
+
+struct BenchMap
+{
+    std::string name;
+    std::vector<std::vector<bool>> obstacles;
+};
+
+struct Backend
+{
+    std::string name;
+    AStar::SearchOptions options;
+};
+
+struct Query
+{
+    Vector2i start;
+    Vector2i goal;
+};
+
+BenchMap loadTiledMap(std::string name, std::string filename)
+{
+    MapGenerator mapGenerator;
+    mapGenerator.generateFromFile(filename);
+    return BenchMap{ name, mapGenerator.elfObstacles };
+}
+
+BenchMap generateOpenMap(int size)
+{
+    return BenchMap{ "open_" + std::to_string(size), std::vector<std::vector<bool>>(size, std::vector<bool>(size, false)) };
+}
+
+BenchMap generateRandomRockMap(int size, int density, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<std::vector<bool>> obstacles(size, std::vector<bool>(size, false));
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            obstacles[y][x] = int(rng() % 100) < density;
+
+    return BenchMap{ "rocks_" + std::to_string(size), obstacles };
+}
+
+BenchMap generateMazeMap(int size, unsigned seed)
+{
+    // recursive backtracker carving corridors between odd coordinates
+    std::mt19937 rng(seed);
+    std::vector<std::vector<bool>> obstacles(size, std::vector<bool>(size, true));
+    static const Vector2i directions[4] = { { 2, 0 }, { -2, 0 }, { 0, 2 }, { 0, -2 } };
+
+    std::vector<Vector2i> stack = { { 1, 1 } };
+    obstacles[1][1] = false;
+    while (stack.size())
+    {
+        Vector2i current = stack.back();
+        std::vector<Vector2i> unvisited;
+        for (Vector2i direction: directions)
+        {
+            Vector2i next = { current.x + direction.x, current.y + direction.y };
+            if (next.x > 0 && next.x < size - 1 && next.y > 0 && next.y < size - 1 && obstacles[next.y][next.x])
+                unvisited.push_back(next);
+        }
+
+        if (unvisited.empty())
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        Vector2i next = unvisited[rng() % unvisited.size()];
+        obstacles[(current.y + next.y) / 2][(current.x + next.x) / 2] = false;
+        obstacles[next.y][next.x] = false;
+        stack.push_back(next);
+    }
+
+    return BenchMap{ "maze_" + std::to_string(size), obstacles };
+}
+
+std::vector<Query> generateQueries(const BenchMap& map, size_t nrOfQueries, unsigned seed)
+{
+    // only pairs within the same region, unreachable goals are rejected before the search in game
+    ConnectedComponents components;
+    components.rebuild(map.obstacles);
+
+    std::mt19937 rng(seed);
+    int height = map.obstacles.size();
+    int width = map.obstacles[0].size();
+    std::vector<Query> queries;
+    size_t attempts = 0;
+    while (queries.size() < nrOfQueries && attempts++ < nrOfQueries * 1000)
+    {
+        Vector2i start = { int(rng() % width), int(rng() % height) };
+        Vector2i goal = { int(rng() % width), int(rng() % height) };
+        if (components.isReachable(start, goal) && !(start == goal))
+            queries.push_back({ start, goal });
+    }
+
+    return queries;
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, size_t(fraction * (values.size() - 1) + 0.5));
+    return values[index];
+}
+
+// false when a budgeted search expanded more nodes than its budget allows
+bool runBackend(const BenchMap& map, const std::vector<Query>& queries, const Backend& backend)
+{
+    std::vector<double> latencies;
+    double totalExpansions = 0;
+    double totalAllocations = 0;
+    double totalWaypoints = 0;
+    int found = 0;
+    int partial = 0;
+    int overBudget = 0;
+
+    latencies.reserve(queries.size());
+    for (const Query& query: queries)
+    {
+        AStar::SearchStats stats;
+        FrameArena::Scope scope; // searches in the game run inside a tick or a job, both use the frame arena
+        size_t allocationsBefore = getHeapAllocationCount();
+        auto begin = std::chrono::steady_clock::now();
+
+        GridPath path = AStar::findPath(query.start, query.goal, map.obstacles, backend.options, &stats);
+
+        auto end = std::chrono::steady_clock::now();
+        totalAllocations += getHeapAllocationCount() - allocationsBefore;
+        latencies.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+        totalExpansions += stats.expansions;
+        totalWaypoints += path.size();
+        found += stats.found;
+        partial += stats.partial;
+        overBudget += backend.options.maxExpansions > 0 && stats.expansions > backend.options.maxExpansions;
+    }
+
+    double count = queries.size() ? double(queries.size()) : 1.0;
+    printf(
+        "{\"map\": \"%s\", \"backend\": \"%s\", \"queries\": %zu, \"found\": %d, \"partial\": %d, "
+        "\"p50_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f, "
+        "\"mean_expansions\": %.1f, \"mean_allocations\": %.1f, \"mean_waypoints\": %.1f}\n",
+        map.name.c_str(), backend.name.c_str(), queries.size(), found, partial,
+        percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 1.0),
+        totalExpansions / count, totalAllocations / count, totalWaypoints / count
+    );
+    fflush(stdout);
+
+    if (overBudget)
+        fprintf(stderr, "%s on %s: %d searches went over the budget of %d expansions\n",
+            backend.name.c_str(), map.name.c_str(), overBudget, backend.options.maxExpansions);
+
+    return !overBudget;
+}
+
+// a path handed from the search to the entity is moved, whatever stays behind must still read as empty and be reusable
+template<typename PathType>
+bool checkMovedFromPath(const char* name, PathType path)
+{
+    path.pushBack({});
+    path.pushFront({});
+    path.pushFront({});
+    path.popFront();
+
+    PathType moved = std::move(path);
+    bool valid = path.empty() && path.size() == 0 && path.begin() == path.end() && moved.size() == 2;
+
+    path.pushFront({});
+    moved = std::move(path);
+    valid &= path.empty() && path.size() == 0 && moved.size() == 1;
+
+    path.pushBack({});
+    valid &= path.size() == 1;
+
+    if (!valid)
+        fprintf(stderr, "a moved-from %s isn't empty\n", name);
+    return valid;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t nrOfQueries = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const unsigned seed = 1337;
+
+    std::vector<BenchMap> maps;
+    maps.push_back(loadTiledMap("map", "map/map.json"));
+    maps.push_back(loadTiledMap("smol", "map/smol.json"));
+    for (int size: { 64, 128, 256, 512 })
+    {
+        maps.push_back(generateOpenMap(size));
+        maps.push_back(generateRandomRockMap(size, 25, seed + size));
+        maps.push_back(generateMazeMap(size + 1, seed + size)); // mazes need an odd size to be closed off
+    }
+
+    std::vector<Backend> backends;
+    AStar::SearchOptions options;
+    options.variant = AStar::SEARCH_ASTAR;              backends.push_back({ "astar", options });
+    options.variant = AStar::SEARCH_BIDIRECTIONAL;      backends.push_back({ "bidirectional", options });
+    options.variant = AStar::SEARCH_WEIGHTED;           backends.push_back({ "weighted", options });
+    options.variant = AStar::SEARCH_CONVEX_UPWARD;      backends.push_back({ "convex_upward", options });
+    options.variant = AStar::SEARCH_CONVEX_DOWNWARD;    backends.push_back({ "convex_downward", options });
+
+    // every variant has to stop at the budget, it bounds the worst case tick
+    options.maxExpansions = constants::PATHFINDING_MAX_EXPANSIONS;
+    options.variant = AStar::SEARCH_ASTAR;              backends.push_back({ "astar_budget", options });
+    options.variant = AStar::SEARCH_BIDIRECTIONAL;      backends.push_back({ "bidirectional_budget", options });
+    options.variant = AStar::SEARCH_WEIGHTED;           backends.push_back({ "weighted_budget", options });
+    options.variant = AStar::SEARCH_CONVEX_UPWARD;      backends.push_back({ "convex_upward_budget", options });
+    options.variant = AStar::SEARCH_CONVEX_DOWNWARD;    backends.push_back({ "convex_downward_budget", options });
+
+    options = AStar::SearchOptions();
+    options.smoothPath = true;                          backends.push_back({ "astar_smoothed", options });
+    options.maxExpansions = constants::PATHFINDING_MAX_EXPANSIONS;
+    backends.push_back({ "astar_smoothed_budget", options }); // what MapGenerator uses in game
+
+    if (!checkMovedFromPath("Path", Path()) || !checkMovedFromPath("GridPath", GridPath(FrameArena::resource())))
+        return 1;
+
+    bool withinBudget = true;
+    for (const BenchMap& map: maps)
+    {
+        std::vector<Query> queries = generateQueries(map, nrOfQueries, seed);
+        for (const Backend& backend: backends)
+            withinBudget &= runBackend(map, queries, backend);
+    }
+
+    return withinBudget ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+baseName = path.getbasename(os.getcwd());
+
+project (baseName)
+    kind "ConsoleApp"
+    location "./"
+    targetdir "../bin/%{cfg.buildcfg}"
+
+    filter "action:vs*"
+        debugdir "$(SolutionDir)"
+
+    filter{}
+
+    vpaths
+    {
+        ["Header Files/*"] = { "include/**.h",  "include/**.hpp", "src/**.h", "src/**.hpp", "**.h", "**.hpp"},
+        ["Source Files/*"] = {"src/**.c", "src/**.cpp","**.c", "**.cpp"},
+    }
+    files {"src/**.cpp", "src/**.h"}
+
+    -- the whole game except its entry point, the simulation drives GameScreen directly
+    files { "../TrollsVsElves/src/**.cpp", "../TrollsVsElves/extras/**.h" }
+    removefiles { "../TrollsVsElves/src/main.cpp" }
+
+    includedirs { "./", "src", "../TrollsVsElves", "../TrollsVsElves/include", "../extras/RakNet/Source" }
+    libdirs { "../extras/RakNet/Lib/Lib/LibStatic" }
+    links { "RakNetLibStatic", "pthread", "z" }
+
+    link_raylib()
+    link_to("jsoncpp")
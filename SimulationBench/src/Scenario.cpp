@@ -0,0 +1,138 @@
+#include "Scenario.h"
+
+static const char* commandNames[] = { "move", "build", "sell", "promote" };
+static const char* buildingNames[] = { "castle", "rock", "hall", "shop" };
+
+template <size_t N>
+static int findName(const char* (&names)[N], std::string name)
+{
+    for (size_t i = 0; i < N; i++)
+        if (name == names[i])
+            return i;
+    return -1;
+}
+
+bool Scenario::load(std::string filename)
+{
+    Json::Value json = parseJsonFile(filename);
+    if (!json.isObject()) // missing or unparsable, parseJsonFile logged why
+        return false;
+
+    nrOfPlayers = json["players"].asInt();
+    nrOfTicks = json["ticks"].asInt();
+
+    commands.clear();
+    for (const Json::Value& obj: json["commands"])
+    {
+        ScenarioCommand command;
+        command.tick = obj["tick"].asInt();
+        command.player = obj["player"].asInt();
+        command.index = { obj.get("x", 0).asInt(), obj.get("y", 0).asInt() };
+        command.target = obj.get("target", 0).asInt();
+
+        int type = findName(commandNames, obj["command"].asString());
+        if (type < 0)
+        {
+            printf("%s: unknown command '%s' at tick %d\n", filename.c_str(), obj["command"].asString().c_str(), command.tick);
+            return false;
+        }
+        command.type = (ScenarioCommandType)type;
+
+        if (command.type == COMMAND_BUILD)
+        {
+            int buildingType = findName(buildingNames, obj["building"].asString());
+            if (buildingType < 0)
+            {
+                printf("%s: unknown building '%s' at tick %d\n", filename.c_str(), obj["building"].asString().c_str(), command.tick);
+                return false;
+            }
+            command.buildingType = (BuildingType)buildingType;
+        }
+
+        commands.push_back(command);
+    }
+
+    std::stable_sort(commands.begin(), commands.end(), [](const ScenarioCommand& lhs, const ScenarioCommand& rhs) {
+        return lhs.tick < rhs.tick;
+    });
+    return true;
+}
+
+void Scenario::save(std::string filename)
+{
+    Json::Value json;
+    json["players"] = nrOfPlayers;
+    json["ticks"] = nrOfTicks;
+    json["commands"] = Json::Value(Json::arrayValue);
+
+    for (const ScenarioCommand& command: commands)
+    {
+        Json::Value obj;
+        obj["tick"] = command.tick;
+        obj["player"] = command.player;
+        obj["command"] = commandNames[command.type];
+        switch (command.type)
+        {
+            case COMMAND_BUILD:
+                obj["building"] = buildingNames[command.buildingType];
+                // fallthrough, builds have a position as well
+            case COMMAND_MOVE:
+                obj["x"] = command.index.x;
+                obj["y"] = command.index.y;
+                break;
+            case COMMAND_SELL:
+            case COMMAND_PROMOTE:
+                obj["target"] = command.target;
+                break;
+        }
+
+        json["commands"].append(obj);
+    }
+
+    std::ofstream file(filename);
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    file << Json::writeString(builder, json) << '\n';
+}
+
+void Scenario::generate(int nrOfPlayers, int nrOfTicks, unsigned seed, const std::vector<std::vector<bool>>& obstacles)
+{
+    // every player issues a command roughly twice a second, mostly moves and builds like a real match
+    this->nrOfPlayers = nrOfPlayers;
+    this->nrOfTicks = nrOfTicks;
+    commands.clear();
+
+    std::mt19937 rng(seed);
+    int height = obstacles.size();
+    int width = obstacles[0].size();
+    auto randomFreeIndex = [&]() {
+        Vector2i index;
+        do index = { int(rng() % width), int(rng() % height) };
+        while (obstacles[index.y][index.x]);
+        return index;
+    };
+
+    for (int tick = 0; tick < nrOfTicks; tick++)
+    {
+        for (int player = 0; player < nrOfPlayers; player++)
+        {
+            if (rng() % 30 != 0)
+                continue;
+
+            ScenarioCommand command;
+            command.tick = tick;
+            command.player = player;
+
+            int roll = rng() % 100;
+            if (roll < 55)          command.type = COMMAND_MOVE;
+            else if (roll < 80)     command.type = COMMAND_BUILD;
+            else if (roll < 95)     command.type = COMMAND_PROMOTE;
+            else                    command.type = COMMAND_SELL;
+
+            command.index = randomFreeIndex();
+            command.buildingType = (BuildingType)(rng() % 4);
+            command.target = rng() % 16;
+            commands.push_back(command);
+        }
+    }
+}
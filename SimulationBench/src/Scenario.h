@@ -0,0 +1,36 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <string>
+#include <vector>
+#include <random>
+
+#include "structs.h"
+#include "BuildingManager.h"
+
+enum ScenarioCommandType { COMMAND_MOVE = 0, COMMAND_BUILD, COMMAND_SELL, COMMAND_PROMOTE };
+
+struct ScenarioCommand
+{
+    int tick = 0;
+    int player = 0;
+    ScenarioCommandType type = COMMAND_MOVE;
+    Vector2i index = { 0, 0 };          // target cell for move and build
+    BuildingType buildingType = ROCK;   // build only
+    int target = 0;                     // sell and promote, picks the player's n-th building (wrapped)
+};
+
+// A recorded list of commands per tick, replayed by SimulationBench.
+// Stored as json: { "players": 4, "ticks": 3600, "commands": [ { "tick": 0, "player": 0, "command": "move", "x": 3, "y": 5 }, ... ] }
+struct Scenario
+{
+    int nrOfPlayers = 1;
+    int nrOfTicks = 0;
+    std::vector<ScenarioCommand> commands; // sorted by tick
+
+    bool load(std::string filename); // false if the file is unreadable or names an unknown command or building
+    void save(std::string filename);
+    void generate(int nrOfPlayers, int nrOfTicks, unsigned seed, const std::vector<std::vector<bool>>& obstacles);
+};
+
+#endif
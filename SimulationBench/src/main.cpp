@@ -0,0 +1,245 @@
+#include "GameScreen.h"
+#include "FrameArena.h"
+#include "GameDataBundle.h"
+#include "InputManager.h"
+#include "JobSystem.h"
+#include "Scenario.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Replays a scenario of build/move/sell/promote commands for N players through GameScreen without a window,
+// stepping the simulation with a fixed timestep as fast as possible, and prints tick time distributions as json lines.
+// Run from the repository root so the game data can be found, e.g.
+//     ./bin/Release/SimulationBench --players 4 --ticks 36000 --record soak.json
+//     ./bin/Release/SimulationBench --scenario soak.json
+//     ./bin/Release/SimulationBench --ticks 0 --bundle gamedata.bin     (startup time with a cooked bundle)
+
+struct Distribution
+{
+    std::string name;
+    std::vector<double> samples; // microseconds
+
+    double percentile(double fraction)
+    {
+        if (samples.empty())
+            return 0.0;
+
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[std::min(sorted.size() - 1, size_t(fraction * (sorted.size() - 1) + 0.5))];
+    }
+
+    double mean()
+    {
+        double sum = 0.0;
+        for (double sample: samples)
+            sum += sample;
+        return samples.empty() ? 0.0 : sum / samples.size();
+    }
+
+    void print()
+    {
+        printf(
+            "{\"phase\": \"%s\", \"samples\": %zu, \"mean_us\": %.2f, \"p50_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f}\n",
+            name.c_str(), samples.size(), mean(), percentile(0.5), percentile(0.99), percentile(1.0)
+        );
+    }
+};
+
+Building* findOwnedBuilding(BuildingManager* buildingManager, Player* player, int target)
+{
+    std::vector<Building*> owned;
+    for (BuildingHandle handle: player->buildings)
+    {
+        Building* building = buildingManager->buildings.get(handle);
+        if (building->buildStage == FINISHED && !building->sold)
+            owned.push_back(building);
+    }
+
+    return owned.empty() ? nullptr : owned[target % owned.size()];
+}
+
+bool isValidIndex(MapGenerator* mapGenerator, Vector2i index)
+{
+    return index.x >= 0 && index.x < mapGenerator->gridSize.x && index.y >= 0 && index.y < mapGenerator->gridSize.y;
+}
+
+void executeCommand(GameScreen* gameScreen, std::vector<Player*>& players, const ScenarioCommand& command)
+{
+    if (command.player < 0 || command.player >= players.size())
+        return;
+
+    Player* player = players[command.player];
+    BuildingManager* buildingManager = gameScreen->buildingManager;
+    MapGenerator* mapGenerator = gameScreen->mapGenerator;
+
+    switch (command.type)
+    {
+        case COMMAND_MOVE:
+            if (isValidIndex(mapGenerator, command.index))
+                gameScreen->movePlayer(player, mapGenerator->indexToWorldPosition(command.index));
+            break;
+
+        case COMMAND_BUILD:
+        {
+            if (!isValidIndex(mapGenerator, command.index))
+                break;
+
+            // same as clicking the build button and then the ground, minus the mouse raycast
+            buildingManager->ghost.set(Building(Cube(buildingManager->defaultBuildingSize), command.buildingType, player));
+            buildingManager->placeGhostBuilding(command.index);
+            if (!gameScreen->buildGhostBuilding(player))
+                buildingManager->ghost.reset(); // colliding, a player would cancel and try elsewhere
+            break;
+        }
+
+        case COMMAND_SELL:
+            if (Building* building = findOwnedBuilding(buildingManager, player, command.target))
+                building->sold = true;
+            break;
+
+        case COMMAND_PROMOTE:
+        {
+            Building* building = findOwnedBuilding(buildingManager, player, command.target);
+            if (!building)
+                break;
+
+            for (const ActionNode& node: ActionsManager::get().getActionChildren(building->actionId))
+            {
+                if (node.type == ACTION_PROMOTE && buildingManager->canPromoteTo(node.id))
+                {
+                    buildingManager->promote(*building, node.id);
+                    break;
+                }
+            }
+            break;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string scenarioFilename = "";
+    std::string recordFilename = "";
+    std::string bundleFilename = "";
+    int nrOfPlayers = 4;
+    int nrOfTicks = 60 * 60 * 10; // ten simulated minutes at 60 ticks per second
+    unsigned seed = 1337;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scenario" && hasValue)        scenarioFilename = argv[++i];
+        else if (arg == "--record" && hasValue)     recordFilename = argv[++i];
+        else if (arg == "--players" && hasValue)    nrOfPlayers = std::atoi(argv[++i]);
+        else if (arg == "--ticks" && hasValue)      nrOfTicks = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)       seed = std::atoi(argv[++i]);
+        else if (arg == "--bundle" && hasValue)     bundleFilename = argv[++i];
+        else if (arg == "--workers" && hasValue)    JobSystem::get().configure(std::max(0, std::atoi(argv[++i]))); // pins the worker count, 0 runs every job inline
+        else
+        {
+            printf("usage: SimulationBench [--scenario file] [--record file] [--players n] [--ticks n] [--seed n] [--bundle file] [--workers n]\n");
+            return 1;
+        }
+    }
+
+    InputManager::get().setSimulated(true);
+    SimulatedInput& input = InputManager::get().getSimulatedInput();
+
+    // startup is everything the game does before its first tick: opening the bundle, loading the actions and the map
+    auto startupBegin = std::chrono::steady_clock::now();
+    bool bundled = bundleFilename.size() && GameDataBundle::get().open(bundleFilename);
+    GameScreen* gameScreen = new GameScreen({ 1280, 800 }, false);
+    MapGenerator* mapGenerator = gameScreen->mapGenerator;
+    double startupTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+    printf("{\"startup_ms\": %.3f, \"bundle\": %s}\n", startupTime, bundled ? "true" : "false");
+
+    Scenario scenario;
+    if (scenarioFilename.size())
+    {
+        if (!scenario.load(scenarioFilename))
+            return 1;
+    }
+    else
+        scenario.generate(nrOfPlayers, nrOfTicks, seed, mapGenerator->elfObstacles);
+
+    if (recordFilename.size())
+        scenario.save(recordFilename);
+
+    // spawn the players spread over free cells, deterministic so runs are comparable
+    std::vector<Player*> players;
+    std::mt19937 rng(seed);
+    for (int i = 0; i < scenario.nrOfPlayers; i++)
+    {
+        Vector2i index;
+        do index = { int(rng() % mapGenerator->gridSize.x), int(rng() % mapGenerator->gridSize.y) };
+        while (mapGenerator->elfObstacles[index.y][index.x]);
+
+        Player* player = new Player(mapGenerator->indexToWorldPosition(index), PLAYER_ELF);
+        gameScreen->playerManager->addPlayer(player);
+        players.push_back(player);
+    }
+    gameScreen->playerManager->clientPlayer = players.empty() ? nullptr : players[0];
+
+    Distribution tickTimes = { "tick" };
+    Distribution commandTimes = { "commands" };
+    Distribution buildingManagerTimes = { "BuildingManager::update" };
+    Distribution playerManagerTimes = { "PlayerManager::update" };
+    Distribution pathfindingTimes = { "pathfinding" };
+    std::vector<double> heapAllocations; // per tick
+    int pathfindingQueries = 0;
+
+    size_t nextCommand = 0;
+    auto wallBegin = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < scenario.nrOfTicks; tick++)
+    {
+        mapGenerator->pathfindingTime = 0.0;
+        mapGenerator->pathfindingQueries = 0;
+        auto tickBegin = std::chrono::steady_clock::now();
+
+        while (nextCommand < scenario.commands.size() && scenario.commands[nextCommand].tick <= tick)
+            executeCommand(gameScreen, players, scenario.commands[nextCommand++]);
+
+        auto updateBegin = std::chrono::steady_clock::now();
+        gameScreen->update();
+        auto tickEnd = std::chrono::steady_clock::now();
+
+        input.clearEvents();
+
+        tickTimes.samples.push_back(std::chrono::duration<double, std::micro>(tickEnd - tickBegin).count());
+        commandTimes.samples.push_back(std::chrono::duration<double, std::micro>(updateBegin - tickBegin).count());
+        buildingManagerTimes.samples.push_back(gameScreen->tickTimings.buildingManager * 1e6);
+        playerManagerTimes.samples.push_back(gameScreen->tickTimings.playerManager * 1e6);
+        pathfindingTimes.samples.push_back(mapGenerator->pathfindingTime * 1e6);
+        pathfindingQueries += mapGenerator->pathfindingQueries;
+        heapAllocations.push_back(gameScreen->tickTimings.heapAllocations);
+    }
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallBegin).count();
+    double simulatedTime = scenario.nrOfTicks * input.frameTime;
+
+    printf(
+        "{\"players\": %d, \"ticks\": %d, \"commands\": %zu, \"buildings\": %zu, \"pathfinding_queries\": %d, "
+        "\"wall_s\": %.3f, \"simulated_s\": %.3f, \"speedup\": %.1f}\n",
+        scenario.nrOfPlayers, scenario.nrOfTicks, scenario.commands.size(), gameScreen->buildingManager->buildings.size(),
+        pathfindingQueries, wallTime, simulatedTime, wallTime > 0.0 ? simulatedTime / wallTime : 0.0
+    );
+    tickTimes.print();
+    commandTimes.print();
+    buildingManagerTimes.print();
+    playerManagerTimes.print();
+    pathfindingTimes.print();
+
+    Distribution allocations = { "heap_allocations", heapAllocations };
+    printf(
+        "{\"heap_allocations_per_tick\": %.2f, \"p50\": %.0f, \"p99\": %.0f, \"max\": %.0f, \"frame_arena_bytes\": %zu}\n",
+        allocations.mean(), allocations.percentile(0.5), allocations.percentile(0.99), allocations.percentile(1.0),
+        FrameArena::get().getCapacity()
+    );
+
+    delete gameScreen;
+    return 0;
+}
@@ -1,49 +1,83 @@
 #ifndef ACTIONS_MANAGER_H
 #define ACTIONS_MANAGER_H
 
+#include <bitset>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <functional>
+#include <mutex>
 #include "utils.h"
 
+class GameDataBundle; // forward declaration to get around circular depenedency
+
+// Dense index of an action, assigned when the action files are loaded
+using ActionId = uint16_t;
+constexpr ActionId NO_ACTION = UINT16_MAX;
+
+constexpr size_t MAX_ACTIONS = 256;
+using ActionSet = std::bitset<MAX_ACTIONS>; // one bit per ActionId
+
+// Buttons that aren't in actions.json, always interned first
+constexpr ActionId FILLER_ACTION = 0;
+constexpr ActionId SELL_ACTION = 1;
+constexpr ActionId BACK_ACTION = 2;
+
+enum ActionType
+{
+    ACTION_NONE = 0,
+    ACTION_BUILD,
+    ACTION_PROMOTE,
+    ACTION_RECRUIT,
+    ACTION_BUY,
+    ACTION_SPELL,
+    ACTION_SELL,
+    ACTION_BACK,
+    ACTION_FILLER
+};
+
 struct ActionNode
 {
-    std::string id;
+    ActionId id = NO_ACTION;
+    std::string key;    // the id in the json files
     std::string name;
-    std::string action;
-    std::vector<std::string> children;
+    ActionType type = ACTION_NONE;
 
     bool promotable = false;
     std::function<void()> callback;
 
-    ActionNode():
-        id(""),
-        name(""),
-        action(""),
-        children({}) {};
-
-    ActionNode(
-        std::string _id,
-        std::string _name,
-        std::string _action,
-        std::vector<std::string> _children
-    ):
+    ActionNode() {};
+
+    ActionNode(ActionId _id, std::string _key, std::string _name, ActionType _type):
         id(_id),
+        key(_key),
         name(_name),
-        action(_action),
-        children(_children) {};
+        type(_type) {};
 };
 
+// The action tree and requirements are loaded once and read-only afterwards,
+// so every match running in the process shares them without locking.
+// Loading interns every key into an ActionId, children are stored as one flat array and
+// the requirements of an action as the set of actions that have to be unlocked first
 class ActionsManager
 {
 private:
     ActionsManager();
 
-    std::unordered_map<std::string, ActionNode> actions;
-public:
-    std::unordered_map<std::string, std::vector<std::string>> requirements;
+    std::vector<ActionNode> nodes;                  // by ActionId, without children
+    std::unordered_map<std::string, ActionId> ids;  // only used while loading and for lookups by key
+    std::vector<uint32_t> childOffsets;             // children of id are children[childOffsets[id]] up to children[childOffsets[id + 1]]
+    std::vector<ActionId> children;
+    std::vector<ActionSet> requirements;            // by ActionId
+    std::once_flag loaded;
+
+    ActionId intern(const std::string& key);
+    void loadActions(std::string filename);
+    void loadRequirements(std::string filename);
+    bool loadBundle(const GameDataBundle& bundle);
 
+public:
     ActionsManager(ActionsManager const&) = delete;
     void operator=(ActionsManager const&) = delete;
     ~ActionsManager();
@@ -54,11 +88,16 @@ public:
         return instance;
     }
 
-    void loadBuildingFile(std::string filename);
-    void loadActions(std::string filename);
-    void loadRequirements(std::string filename);
+    // only the first call loads anything, from the game data bundle when it is open and up to date
+    void load(std::string requirementsFilename, std::string actionsFilename);
+
+    ActionId getId(const std::string& key) const; // NO_ACTION for unknown keys
+    const ActionNode& getNode(ActionId id) const;
+    const std::string& getKey(ActionId id) const;
+    size_t size() const;
 
-    std::vector<ActionNode> getActionChildren(std::string id);
+    std::vector<ActionNode> getActionChildren(ActionId id) const;
+    const ActionSet& getRequirements(ActionId id) const;
 };
 
 #endif
@@ -0,0 +1,16 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// Linking AllocationCounter.cpp replaces the global operator new to count every call, from any thread.
+// The nothrow and aligned forms are counted too, only the nothrow aligned ones are left to the standard library.
+// Only the benches link it, the game keeps the standard operator new and always reads 0
+inline uint64_t (*heapAllocationCounter)() = nullptr; // set by AllocationCounter.cpp when it is linked
+
+inline uint64_t getHeapAllocationCount()
+{
+    return heapAllocationCounter ? heapAllocationCounter() : 0;
+}
+
+#endif
@@ -9,7 +9,7 @@ private:
 public:
     BaseScreen();
     BaseScreen(Vector2i screenSize);
-    ~BaseScreen();
+    virtual ~BaseScreen();
 
     virtual void draw() = 0;
     virtual void update() = 0;
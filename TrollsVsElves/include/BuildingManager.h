@@ -1,6 +1,7 @@
 #ifndef BUILDING_MANAGER_H
 #define BUILDING_MANAGER_H
 
+#include <array>
 #include <vector>
 #include <deque>
 #include <unordered_map>
@@ -10,12 +11,17 @@
 #include "MapGenerator.h"
 #include "CameraManager.h"
 #include "ActionsManager.h"
+#include "InputManager.h"
+#include "InstancedRenderer.h"
+#include "SlotMap.h"
 
 class Player; // forward declaration to get around circular depenedency
 
 enum BuildStage { GHOST = 0, SCHEDULED, IN_PROGRESS, FINISHED };
 enum BuildingType { CASTLE = 0, ROCK, HALL, SHOP };
 
+using BuildingHandle = SlotHandle;
+
 struct Building
 {
     Cube cube;
@@ -27,7 +33,6 @@ struct Building
     Color targetColor;
 
     float buildTime = 0.2f;
-    float buildTimer = 0.f;
 
     bool selected = false;
 
@@ -35,19 +40,20 @@ struct Building
 
     Player* owner;
     BuildingType buildingType;
-    std::string actionId;
-    std::vector<std::string> previousActionIds;
+    ActionId actionId;
+    std::vector<ActionId> previousActionIds;
     bool sold = false;
 
     Building() = delete;
     Building(Cube _cube, BuildingType _buildingType, Player* _owner) : cube(_cube), buildingType(_buildingType), owner(_owner)
     {
+        ActionsManager& actionsManager = ActionsManager::get();
         switch (buildingType)
         {
-            case ROCK:      targetColor = Color{ 100, 100, 100, 255 };  actionId = "rock0";     break;
-            case CASTLE:    targetColor = BEIGE;                        actionId = "castle0";   break;
-            case HALL:      targetColor = BLUE;                         actionId = "hall0";     break;
-            case SHOP:      targetColor = SKYBLUE;                      actionId = "shop0";     break;
+            case ROCK:      targetColor = Color{ 100, 100, 100, 255 };  actionId = actionsManager.getId("rock0");     break;
+            case CASTLE:    targetColor = BEIGE;                        actionId = actionsManager.getId("castle0");   break;
+            case HALL:      targetColor = BLUE;                         actionId = actionsManager.getId("hall0");     break;
+            case SHOP:      targetColor = SKYBLUE;                      actionId = actionsManager.getId("shop0");     break;
         }
 
         Vector3 targetColorHSL = ColorToHSV(targetColor);
@@ -57,6 +63,17 @@ struct Building
     ~Building() {}
 };
 
+// A building under construction, its timer and color are kept apart so the per tick pass runs over one array
+struct BuildProgress
+{
+    BuildingHandle handle;
+    float timer;
+    float time;
+    Color from;
+    Color to;
+    Color color;    // written by the pass, copied to the building afterwards
+};
+
 struct OptionalBuilding
 {
     std::optional<Building> _building;
@@ -73,14 +90,20 @@ struct BuildingManager
     Vector3 defaultBuildingSize;
     Color defaultBuildingColor;
 
-    std::vector<Building> buildings;
-    std::deque<Building> buildQueue;
+    SlotMap<Building> buildings;            // every placed building, scheduled ones included
+    std::vector<BuildProgress> inProgress;  // unordered, every IN_PROGRESS building has one
     OptionalBuilding ghost;
-    int selectedIndex;
+    BuildingHandle selected;
 
     MapGenerator* mapGenerator;
+    CameraManager* cameraManager;
+
+    std::array<unsigned, MAX_ACTIONS> unlockCounts; // buildings currently holding each action, by ActionId
+    ActionSet unlockedActions;                      // actions with a count above zero
+    uint64_t unlockedActionsVersion;                // bumped whenever unlockedActions changes, cached action lists compare it
 
-    std::unordered_map<std::string, unsigned> unlockedActions;
+    void unlock(ActionId id);
+    void lock(ActionId id);
 
     void updateGhostBuilding();
 
@@ -88,32 +111,40 @@ struct BuildingManager
     bool isColliding(const Container& buildings, Building* targetBuilding);
 
     BuildingManager() = delete;
-    BuildingManager(Vector3 defaultBuildingSize, Color defaultBuildingColor, MapGenerator* mapGenerator);
+    BuildingManager(Vector3 defaultBuildingSize, Color defaultBuildingColor, MapGenerator* mapGenerator, CameraManager* cameraManager);
     ~BuildingManager();
 
-    void draw();
+    DrawCounts draw(const Frustum& frustum, InstancedRenderer& renderer);
+    void drawGhost(); // translucent, after the instanced buildings are drawn
     void update();
+    void advanceBuilds(size_t begin, size_t end, float dt); // only touches inProgress[begin, end), ranges can run in parallel
 
-    Building* raycastToBuilding();
-    void removeBuilding(size_t index);
+    BuildingHandle raycastToBuilding();
+    BuildingHandle addBuilding(Building building); // also hands it to its owner
+    void removeBuilding(BuildingHandle handle);
+    Building* getSelectedBuilding();
 
-    Building* yieldBuildQueue();
-    Building* buildQueueFront();
-    void clearBuildQueue();
+    // every player has a build queue of their own, the buildings are started one by one as the player reaches them
+    Building* yieldBuildQueue(Player* player);
+    Building* buildQueueFront(Player* player);
+    void clearBuildQueue(Player* player);
 
     void createDebugBuilding(Vector2i index, BuildingType type);
     void createNewGhostBuilding(BuildingType buildingType, Player* player);
+    void placeGhostBuilding(Vector2i index);
+    Vector3 indexToBuildingPosition(Vector2i index);
     void scheduleGhostBuilding();
     void progressBuilding(Building& building, BuildStage stage);
 
-    void select(Building* building);
+    void select(BuildingHandle handle);
     void deselect();
 
     void recruit(Building* building);
-    bool canPromoteTo(std::string id);
-    void promote(Building& building, std::string id);
+    bool canPromoteTo(ActionId id);
+    void promote(Building& building, ActionId id);
 
-    std::vector<ActionNode> getActions(Building& building, int nrOfButton);
+    // the callbacks hold the handle, they do nothing once the building is gone
+    std::vector<ActionNode> getActions(BuildingHandle handle, int nrOfButtons);
 };
 
 #endif
@@ -4,22 +4,22 @@
 #include "utils.h"
 #include "structs.h"
 #include "rcamera.h"
+#include "InputManager.h"
 
+// Owned by each GameScreen, a match host runs many of them side by side
 class CameraManager
 {
 private:
-    CameraManager();
     Camera3D camera;
     Camera2D camera2D;
     Matrix cameraViewMatrix;
+    Matrix viewProjection;  // both cached once per update, so projecting a point is a handful of multiplications
+    Vector2 screenSize;
 
+    void updateProjection();
 
 public:
-    static CameraManager& get()
-    {
-        static CameraManager instance;
-        return instance;
-    }
+    CameraManager();
 
     void update();
 
@@ -27,7 +27,8 @@ public:
     Camera2D& getCamera2D();
     Matrix getCameraViewMatrix();
     Ray getMouseRay();
-    Vector2 getWorldToScreen(Vector3 position);
+    Frustum getFrustum(); // of the current frame, for culling
+    Vector2 getWorldToScreen(Vector3 position); // like raylib's GetWorldToScreen, as of the last update
 
     float calculateCircleRadius2D(Vector3 position, float radius);
     Circle convertSphereToCircle(Vector3 position, float radius);
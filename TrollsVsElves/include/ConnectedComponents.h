@@ -0,0 +1,55 @@
+#ifndef CONNECTED_COMPONENTS_H
+#define CONNECTED_COMPONENTS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "structs.h"
+
+// Labels every traversable cell of an obstacle map with the 8-connected region it belongs to,
+// so whether two cells can reach each other is a single label comparison.
+struct ConnectedComponents
+{
+    static constexpr int BLOCKED = -1;
+
+    Vector2i size;
+    std::vector<int> labels;                    // one label per cell, BLOCKED for obstacles
+    std::vector<int> componentSizes;            // number of cells per label, 0 when the label is unused
+    std::vector<int> freeLabels;                // labels whose size dropped to 0, reused before new ones
+    std::vector<std::vector<bool>> obstacles;   // copy of the obstacle map the labels were computed for
+
+    ConnectedComponents();
+    ~ConnectedComponents();
+
+    void rebuild(const std::vector<std::vector<bool>>& obstacles);
+    void update(const std::vector<std::vector<bool>>& obstacles);
+
+    int getLabel(Vector2i index);
+    bool isReachable(Vector2i from, Vector2i to);
+    Vector2i findNearestReachable(Vector2i from, Vector2i to);
+
+private:
+    // one search of separatePieces, merged searches point at the one that took over their cells
+    struct PieceSearch
+    {
+        std::vector<Vector2i> frontier;
+        size_t head = 0;                // frontier before it has been expanded
+        std::vector<Vector2i> cells;    // every cell this search and the ones merged into it claimed
+        size_t parent;
+        bool finished = false;
+    };
+
+    std::vector<uint32_t> visitStamps;  // per cell, the separatePieces call that claimed it last
+    std::vector<size_t> visitOwners;    // per cell, the search that claimed it
+    uint32_t visitStamp;
+
+    bool inBounds(Vector2i index);
+    int newLabel();
+    void addToComponent(int label, int count);
+    void flood(Vector2i from, int label, int expectedLabel);
+    void block(std::vector<Vector2i>& cells);
+    void separatePieces(int label, const std::vector<Vector2i>& seeds);
+    void unblock(std::vector<Vector2i>& cells);
+};
+
+#endif
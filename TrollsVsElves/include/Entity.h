@@ -1,10 +1,11 @@
 #ifndef ENTITY_H
 #define ENTITY_H
 
-#include <deque>
-
 #include "utils.h"
 #include "structs.h"
+#include "Path.h"
+#include "InputManager.h"
+#include "InstancedRenderer.h"
 
 enum State { IDLE, RUNNING };
 enum EntityType { PLAYER, WORKER };
@@ -24,7 +25,7 @@ struct Entity
     Vector3 speed;
     bool reachedDestination;
     float defaultTargetMargin;
-    std::deque<Vector3> path;
+    Path path;
 
     bool selected;
 
@@ -32,13 +33,13 @@ struct Entity
     Entity(Vector3 position, Color defaultColor, EntityType entityType);
     ~Entity();
 
-    void draw();
+    void draw(InstancedRenderer& renderer);
     void update();
     void updateMovement();
 
     Vector3 getPosition();
-    void setPath(std::vector<Vector3> newPath);
-    void correctPath(std::vector<Vector3> path);
+    void setPath(Path newPath);
+    void correctPath(Path path);
     void setDefaultColor(Color color);
     void setPosition(Vector3 position);
     void setSpeed(Vector3 speed);
@@ -0,0 +1,68 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that doesn't outlive the current tick, one per thread. It only hands out memory while a
+// Scope is open on its thread and takes all of it back when that Scope closes, deallocating does nothing. Once the
+// buffer is full the rest comes from the heap, and the buffer grows when the outermost Scope closes, so a steady
+// workload stops touching the heap after a few ticks.
+// Containers using it must not outlive the Scope they were filled in, nor be handed to another thread
+class FrameArena: public std::pmr::memory_resource
+{
+private:
+    struct Overflow
+    {
+        void* pointer;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    std::vector<std::byte> buffer;
+    size_t used;
+    size_t overflowBytes;
+    size_t peak;                    // most bytes in use at once since the outermost scope opened, overflow included
+    size_t depth;                   // open scopes
+    std::vector<Overflow> overflow; // heap allocations made while the buffer was full
+
+    FrameArena();
+
+    void rewind(size_t mark, size_t overflowMark);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+    // everything allocated on this thread while it is open is released when it closes, scopes nest
+    class Scope
+    {
+    private:
+        FrameArena& arena;
+        size_t mark;
+        size_t overflowMark;
+
+    public:
+        Scope();
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static FrameArena& get()
+    {
+        static thread_local FrameArena instance;
+        return instance;
+    }
+
+    ~FrameArena();
+
+    // this thread's arena while a scope is open, the heap otherwise
+    static std::pmr::memory_resource* resource();
+
+    size_t getCapacity();
+};
+
+#endif
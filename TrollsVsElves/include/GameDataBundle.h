@@ -0,0 +1,107 @@
+#ifndef GAME_DATA_BUNDLE_H
+#define GAME_DATA_BUNDLE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "ActionsManager.h"
+
+struct MapTemplate; // forward declaration, defined in MapGenerator.h
+
+constexpr uint32_t GAME_DATA_BUNDLE_VERSION = 1;     // bump whenever the layout below changes
+constexpr uint32_t GAME_DATA_BUNDLE_ENDIANNESS = 0x01020304;
+
+// Layout of a bundle written by GameDataCooker. Offsets are in bytes from the start of the file and every
+// section starts 8 byte aligned, so the tables are used in place once the file is mapped. Native byte order
+struct BundleString
+{
+    uint32_t offset;    // into the string section, not null terminated
+    uint32_t length;
+};
+
+struct BundleAction
+{
+    BundleString key;
+    BundleString name;
+    uint32_t type;      // ActionType
+};
+
+struct BundleMap
+{
+    BundleString filename;  // the json file it was cooked from
+    int32_t width;
+    int32_t height;
+    uint32_t nrOfLayers;
+    uint32_t padding;
+    uint64_t tilesOffset;   // nrOfLayers * width * height int32_t tile types, row major per layer
+};
+
+struct BundleHeader
+{
+    char magic[4];              // "TVEB"
+    uint32_t version;
+    uint32_t endianness;        // GAME_DATA_BUNDLE_ENDIANNESS as written by the cooker
+    uint32_t maxActions;        // MAX_ACTIONS of the cooker, the requirement sets are this many bits
+    uint64_t fileSize;
+
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+
+    uint64_t actionsOffset;         // nrOfActions BundleAction, indexed by ActionId
+    uint64_t childOffsetsOffset;    // nrOfActions + 1 uint32_t, the children of an action are children[offsets[id], offsets[id + 1])
+    uint64_t childrenOffset;        // nrOfChildren ActionId
+    uint64_t requirementsOffset;    // nrOfActions * maxActions / 64 uint64_t, bit i of an action's words is ActionId i
+    uint32_t nrOfActions;
+    uint32_t nrOfChildren;
+
+    uint64_t mapsOffset;            // nrOfMaps BundleMap
+    uint32_t nrOfMaps;
+    uint32_t padding;
+};
+
+// Read-only view of a cooked bundle, mapped into memory for the lifetime of the process.
+// Nothing is used from it unless it was opened and is at least as new as the json file it replaces
+class GameDataBundle
+{
+private:
+    GameDataBundle();
+
+    std::string filename;
+    std::filesystem::file_time_type modified;
+    const char* data;
+    size_t size;
+    std::vector<char> buffer;   // holds the file where it can't be mapped
+
+    bool validate();
+    void close();
+
+public:
+    static GameDataBundle& get()
+    {
+        static GameDataBundle instance;
+        return instance;
+    }
+
+    GameDataBundle(GameDataBundle const&) = delete;
+    void operator=(GameDataBundle const&) = delete;
+    ~GameDataBundle();
+
+    // false, and the json files are used, when missing or invalid. Opened once at startup and never closed,
+    // map templates point into it
+    bool open(std::string filename);
+    bool isOpen() const;
+    bool isFresh(const std::string& sourceFilename) const; // the source wasn't changed after cooking
+
+    const BundleHeader& getHeader() const;
+    std::string getString(BundleString string) const;
+    const BundleAction* getActions() const;
+    const uint32_t* getChildOffsets() const;
+    const ActionId* getChildren() const;
+    const uint64_t* getRequirements(ActionId id) const;
+
+    bool loadMap(const std::string& filename, MapTemplate& mapTemplate) const;
+};
+
+#endif
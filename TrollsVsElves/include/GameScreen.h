@@ -11,6 +11,8 @@
 #include "CameraManager.h"
 #include "ActionsManager.h"
 #include "ThreadSafeMessageQueue.h"
+#include "InputManager.h"
+#include "WorldSnapshot.h"
 
 #include <chrono>
 #include <vector>
@@ -30,7 +32,27 @@ enum RaycastHitType {
 struct RayCollisionObject
 {
     RaycastHitType type;
-    std::variant<std::monostate, Player*, Entity*, Building*, Cube*> object;
+    std::variant<std::monostate, Player*, Entity*, BuildingHandle, Cube> object;
+};
+
+// Seconds spent in each phase of the last GameScreen::update()
+struct TickTimings
+{
+    double messages = 0;
+    double buildingManager = 0;
+    double playerManager = 0;
+    double input = 0;
+    uint64_t heapAllocations = 0; // not seconds, operator new calls during it by any thread, the network thread included, 0 unless a bench links AllocationCounter.cpp
+};
+
+// Buttons of the action window, rebuilt only when the selection, its actionId or the unlocked actions change
+struct ActionPanel
+{
+    const void* owner = nullptr;    // the selected building or player the buttons were built for
+    BuildingHandle building;        // buildings move around in memory, another one may end up at owner
+    ActionId actionId = NO_ACTION;
+    uint64_t unlockedActionsVersion = 0;
+    std::vector<ActionNode> buttons;
 };
 
 struct NetworkManager; // forward declaration to get around circular depenedency
@@ -48,12 +70,22 @@ class GameScreen: public BaseScreen
 
         std::chrono::steady_clock::time_point lastLeftMouseButtonClick;
 
+        ActionPanel actionPanel;
+        const std::vector<ActionNode>& getActionButtons(size_t nrOfButtons);
+
     public:
         BuildingManager* buildingManager;
         PlayerManager* playerManager;
         NetworkManager* networkManager;
         MapGenerator* mapGenerator;
+        CameraManager* cameraManager;
+        InstancedRenderer* renderer;
         ThreadSafeMessageQueue messageQueue;
+        TickTimings tickTimings;
+        CullingStats cullingStats;
+        bool showCullingStats;
+        WorldSnapshotBuffer snapshots;  // published at the end of every tick, what other threads may read of the world
+        uint64_t tick;
 
         GameScreen() = delete;
         GameScreen(Vector2i screenSize, bool isSinglePlayer);
@@ -61,6 +93,9 @@ class GameScreen: public BaseScreen
 
         void draw();
         void update();
+        void updateSimulation(); // everything but the local camera and mouse, all a headless match needs
+        void publishSnapshot();
+        void handleInput();
 
         void startMultiSelection();
         void stopMultiSelection();
@@ -69,6 +104,9 @@ class GameScreen: public BaseScreen
         RayCollisionObject raycastWorld();
         void handleLeftMouseButton();
         void handleRightMouseButton();
+
+        void movePlayer(Player* player, Vector3 position);
+        bool buildGhostBuilding(Player* player);
 };
 
 #endif
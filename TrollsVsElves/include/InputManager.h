@@ -0,0 +1,62 @@
+#ifndef INPUT_MANAGER_H
+#define INPUT_MANAGER_H
+
+#include "raylib.h"
+
+#include <unordered_set>
+
+// State used instead of the real devices while the InputManager is simulated
+struct SimulatedInput
+{
+    Vector2 mousePosition = { 0.f, 0.f };
+    float mouseWheelMove = 0.f;
+    float frameTime = 1/60.f;   // fixed timestep, lets a driver run the simulation faster than real time
+
+    std::unordered_set<int> mouseButtonsPressed;
+    std::unordered_set<int> mouseButtonsDown;
+    std::unordered_set<int> mouseButtonsReleased;
+    std::unordered_set<int> keysPressed;
+    std::unordered_set<int> keysDown;
+
+    void clearEvents() // pressed/released only last a single tick
+    {
+        mouseButtonsPressed.clear();
+        mouseButtonsReleased.clear();
+        keysPressed.clear();
+        mouseWheelMove = 0.f;
+    }
+};
+
+// Every read of the mouse, keyboard and frame time in game logic goes through here,
+// so the game can be driven without a window or input devices (see SimulationBench)
+class InputManager
+{
+private:
+    InputManager();
+
+    bool simulated;
+    SimulatedInput simulatedInput;
+
+public:
+    static InputManager& get()
+    {
+        static InputManager instance;
+        return instance;
+    }
+
+    void setSimulated(bool simulated);
+    bool isSimulated();
+    SimulatedInput& getSimulatedInput();
+
+    Vector2 getMousePosition();
+    float getMouseWheelMove();
+    float getFrameTime();
+
+    bool isMouseButtonPressed(int button);
+    bool isMouseButtonDown(int button);
+    bool isMouseButtonReleased(int button);
+    bool isKeyPressed(int key);
+    bool isKeyDown(int key);
+};
+
+#endif
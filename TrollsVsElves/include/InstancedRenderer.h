@@ -0,0 +1,44 @@
+#ifndef INSTANCED_RENDERER_H
+#define INSTANCED_RENDERER_H
+
+#include "structs.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+// Collects the cubes and capsules of a frame and draws them with GPU instancing, one draw call per mesh and color.
+// Meshes are built once per cube size and capsule shape. raylib only takes a transform per instance, so instances
+// are batched by color instead, there are only a handful of colors in play at a time.
+// Everything is loaded on first use, GameScreen is created before the window
+class InstancedRenderer
+{
+private:
+    struct Batch
+    {
+        size_t meshIndex;
+        Color color;
+        std::vector<Matrix> transforms; // kept between frames to reuse the capacity
+    };
+
+    bool loaded;
+    Shader shader;
+    Material material;
+    std::vector<Mesh> meshes;
+    std::map<std::tuple<float, float, float>, size_t> cubeMeshes;     // by size
+    std::map<std::tuple<float, float, int, int>, size_t> capsuleMeshes; // by radius, height, slices and rings
+    std::map<std::tuple<size_t, uint32_t>, Batch> batches;            // by mesh and color
+
+    void load();
+    void add(size_t meshIndex, Color color, Vector3 position);
+
+public:
+    InstancedRenderer();
+    ~InstancedRenderer();
+
+    void addCube(const Cube& cube);
+    void addCapsule(const Capsule& capsule); // capsules are always upright
+    int flush(); // draws everything added since the last flush, returns the number of draw calls
+};
+
+#endif
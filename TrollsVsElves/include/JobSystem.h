@@ -0,0 +1,98 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeMessageQueue.h"
+
+// The jobs of a batch that haven't finished yet
+struct JobCounter
+{
+    std::atomic<size_t> pending = 0;
+};
+
+// Work-stealing scheduler for the simulation. Every worker pops its own jobs newest first and steals the oldest
+// jobs of the others when it runs out. Threads outside the pool share one more queue, and waiting on a counter
+// runs queued jobs instead of blocking, so jobs may be started and waited on from anywhere, jobs included.
+// With zero workers every job runs on the thread that waits for it, in submission order
+class JobSystem
+{
+private:
+    struct Job
+    {
+        Task task;
+        JobCounter* counter;
+    };
+
+    struct JobQueue
+    {
+        std::deque<Job> jobs;
+        std::mutex mutex;
+    };
+
+    JobSystem();
+
+    std::vector<std::unique_ptr<JobQueue>> queues;  // one per worker, the last one is shared by every other thread
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued;                     // jobs in any queue, workers sleep while it is zero
+    std::mutex sleepMutex;
+    std::condition_variable jobAvailable;
+    bool stopping;
+
+    void start(size_t nrOfWorkers);
+    void stop();
+    void work(size_t index);
+    JobQueue& getOwnQueue();
+    bool runOne(); // false when there was nothing to run
+
+public:
+    static JobSystem& get()
+    {
+        static JobSystem instance;
+        return instance;
+    }
+
+    ~JobSystem();
+
+    // replaces the workers, only while no jobs are queued. Defaults to one less than the number of cores
+    void configure(size_t nrOfWorkers);
+    size_t getWorkerCount();
+
+    void submit(Task task, JobCounter& counter);
+    void wait(JobCounter& counter); // runs queued jobs until every job of the counter has finished
+
+    // calls body on consecutive ranges of at most grainSize indices, in parallel, blocks until all are done.
+    // Runs inline when it fits in one range
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body);
+};
+
+// Jobs with dependencies. A job is submitted once every job it depends on has finished, a graph can be run again
+class JobGraph
+{
+private:
+    struct Node
+    {
+        Task task;
+        std::vector<size_t> successors;
+        size_t dependencies = 0;
+        std::atomic<size_t> remaining = 0;
+    };
+
+    std::deque<Node> nodes; // never moved, running jobs refer to them
+
+    void submit(size_t index, JobCounter& counter);
+
+public:
+    size_t add(Task task, std::initializer_list<size_t> dependencies = {}); // dependencies are earlier return values
+    void run(); // blocks until every job has run
+};
+
+#endif
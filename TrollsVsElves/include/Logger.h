@@ -0,0 +1,235 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+enum LogLevel
+{
+    LOG_LEVEL_TRACE = 0,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_ERROR
+};
+
+// Messages below LOG_MIN_LEVEL are compiled out entirely, their arguments are never evaluated. They stay in a dead
+// printf call so variables only logged don't turn into unused warnings.
+// Defaults to DEBUG in Debug builds and INFO otherwise, define it to override (0 = TRACE ... 4 = ERROR)
+#ifndef LOG_MIN_LEVEL
+    #ifdef DEBUG
+        #define LOG_MIN_LEVEL 1
+    #else
+        #define LOG_MIN_LEVEL 2
+    #endif
+#endif
+
+// Argument bytes of a record. Arguments are captured in binary and only formatted on the flush thread
+struct LogWriter
+{
+    char* data;
+    size_t capacity;
+    size_t size = 0;
+    bool overflow = false;
+
+    void write(const void* source, size_t bytes)
+    {
+        if (overflow || size + bytes > capacity)
+        {
+            overflow = true;
+            return;
+        }
+        memcpy(data + size, source, bytes);
+        size += bytes;
+    }
+};
+
+struct LogReader
+{
+    const char* data;
+    size_t size = 0;
+
+    void read(void* destination, size_t bytes)
+    {
+        memcpy(destination, data + size, bytes);
+        size += bytes;
+    }
+};
+
+// Arithmetic types and pointers are copied as is, enums as their underlying type
+template<typename T, typename = void>
+struct LogArgument
+{
+    static_assert(std::is_arithmetic_v<T> || std::is_pointer_v<T>, "unsupported log argument type");
+    using Decoded = T;
+
+    static void encode(LogWriter& writer, const T& value) { writer.write(&value, sizeof(value)); }
+    static Decoded decode(LogReader& reader) { Decoded value; reader.read(&value, sizeof(value)); return value; }
+};
+
+template<typename T>
+struct LogArgument<T, std::enable_if_t<std::is_enum_v<T>>>
+{
+    using Decoded = std::underlying_type_t<T>;
+
+    static void encode(LogWriter& writer, const T& value) { Decoded decoded = Decoded(value); writer.write(&decoded, sizeof(decoded)); }
+    static Decoded decode(LogReader& reader) { Decoded value; reader.read(&value, sizeof(value)); return value; }
+};
+
+// Strings are copied into the record, the caller's buffer may be gone by the time the record is formatted
+template<>
+struct LogArgument<const char*>
+{
+    using Decoded = const char*;
+
+    static void encode(LogWriter& writer, const char* value)
+    {
+        if (!value)
+            value = "(null)";
+        writer.write(value, strlen(value) + 1);
+    }
+
+    static Decoded decode(LogReader& reader)
+    {
+        const char* value = reader.data + reader.size;
+        reader.size += strlen(value) + 1;
+        return value;
+    }
+};
+
+template<> struct LogArgument<char*> : LogArgument<const char*> {};
+
+using LogFormatter = int (*)(char* buffer, size_t size, const char* format, const char* data);
+
+struct LogRecord
+{
+    static constexpr size_t DATA_SIZE = 216;
+
+    LogLevel level;
+    uint32_t threadId;
+    uint64_t timestamp;         // nanoseconds since the logger was created
+    const char* format;         // must be a string literal, only the pointer is stored
+    LogFormatter formatter;     // nullptr when the arguments didn't fit, the bare format is printed instead
+    char data[DATA_SIZE];
+};
+
+int formatLogMessage(char* buffer, size_t size, const char* format, ...);
+
+template<typename... Args>
+int formatLogRecord(char* buffer, size_t size, const char* format, const char* data)
+{
+    LogReader reader = { data };
+    (void)reader; // unused without arguments
+    std::tuple<typename LogArgument<Args>::Decoded...> arguments { LogArgument<Args>::decode(reader)... }; // braces keep the order
+    return std::apply([&](auto... values) { return formatLogMessage(buffer, size, format, values...); }, arguments);
+}
+
+// Asynchronous logger. Any thread pushes binary records into a bounded lock-free queue without formatting or I/O,
+// a background thread formats them and writes them to stderr in batches. When the queue is full messages are dropped
+// and counted rather than blocking the caller
+class Logger
+{
+private:
+    static constexpr size_t CAPACITY = 4096; // records, must be a power of two
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    Logger();
+
+    Slot* slots;
+    std::atomic<size_t> enqueuePosition;
+    size_t dequeuePosition;                 // only touched by the flush thread
+    std::atomic<size_t> writtenPosition;    // every record before this one has reached stderr
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> running;
+    std::thread thread;
+    uint64_t epoch;
+
+    LogRecord* beginRecord(size_t& position);
+    void commitRecord(size_t position);
+    size_t drain(std::string& output);
+    void run();
+
+public:
+    std::atomic<int> level; // runtime filter on top of LOG_MIN_LEVEL
+
+    static Logger& get()
+    {
+        static Logger instance;
+        return instance;
+    }
+
+    ~Logger();
+
+    uint64_t now();
+    uint32_t getThreadId();
+    void flush(); // blocks until everything logged so far has been written
+
+    template<typename... Args>
+    void log(LogLevel level, const char* format, const Args&... args)
+    {
+        if (level < this->level.load(std::memory_order_relaxed))
+            return;
+
+        size_t position;
+        LogRecord* record = beginRecord(position);
+        if (!record)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        record->level = level;
+        record->threadId = getThreadId();
+        record->timestamp = now();
+        record->format = format;
+
+        LogWriter writer = { record->data, LogRecord::DATA_SIZE };
+        (LogArgument<std::decay_t<Args>>::encode(writer, args), ...);
+        record->formatter = writer.overflow ? nullptr : &formatLogRecord<std::decay_t<Args>...>;
+
+        commitRecord(position);
+    }
+};
+
+// The dead printf call lets the compiler check the format string against the arguments
+#define LOG_AT(level, ...) do { if (false) printf(__VA_ARGS__); Logger::get().log(level, __VA_ARGS__); } while (0)
+#define LOG_DISABLED(...) do { if (false) printf(__VA_ARGS__); } while (0)
+
+#if LOG_MIN_LEVEL <= 0
+    #define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+    #define LOG_TRACE(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+    #define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+    #define LOG_DEBUG(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= 2
+    #define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+    #define LOG_INFO(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= 3
+    #define LOG_WARNING(...) LOG_AT(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+    #define LOG_WARNING(...) LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
@@ -2,34 +2,116 @@
 #define MAP_GENERATOR_H
 
 #include <vector>
-#include <list>
+#include <memory_resource>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
 #include "structs.h"
 #include "PathFinding.h"
-#include "CameraManager.h"
+#include "ConnectedComponents.h"
+#include "constants.h"
+
+// A parsed map file, only the tile types of each layer
+struct MapTemplate
+{
+    Vector2i gridSize;
+    int nrOfLayers = 0;
+    const int32_t* tiles = nullptr; // nrOfLayers * gridSize.x * gridSize.y types, row major per layer
+    std::vector<int32_t> storage;   // owns the tiles, unless they point into the game data bundle
+
+    MapTemplate() {}
+    MapTemplate(const MapTemplate&) = delete; // tiles may point into storage
+
+    const int32_t* getLayer(int layer) const { return tiles + size_t(layer) * gridSize.x * gridSize.y; }
+};
+
+// Map files are parsed once per process and shared read-only by every MapGenerator built from them
+class MapTemplateCache
+{
+private:
+    MapTemplateCache() {}
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const MapTemplate>> templates;
+
+public:
+    static MapTemplateCache& get()
+    {
+        static MapTemplateCache instance;
+        return instance;
+    }
+
+    std::shared_ptr<const MapTemplate> load(std::string filename);
+};
+
+enum TileType: uint8_t
+{
+    TILE_EMPTY = 0,
+    TILE_GROUND,
+    TILE_OBSTRUCTION,
+};
+
+// What remains of a tile once the map is generated, its cube is derived from its index when needed
+struct MapTile
+{
+    TileType type = TILE_EMPTY;
+    uint8_t layer = 0;  // height in cubes above the ground, of the topmost layer that isn't empty
+};
+
+// A square of tiles, the unit of mesh building and culling
+struct MapChunk
+{
+    Vector2i origin;            // index of the first tile
+    Vector2i size;              // chunks along the far edges of the map may be smaller
+    std::vector<MapTile> tiles; // row major
+    BoundingBox bounds;
+    Mesh mesh;                  // only built once the chunk is first visible
+    bool hasMesh = false;
+};
 
 struct MapGenerator
 {
-    std::vector<Cube> grid;
+    std::vector<MapChunk> chunks;
+    Vector2i nrOfChunks;
+    std::vector<Vector2i> highlightedTiles; // the last path found, drawn on top of the chunks
+    std::vector<bool> visibleChunks;        // from the last draw, including the culling margin
+    Material chunkMaterial;
+    bool hasChunkMaterial;
     std::vector<std::vector<bool>> obstacles;
     std::vector<std::vector<bool>> elfObstacles;
     std::vector<std::vector<bool>> trollObstacles;
+    ConnectedComponents elfComponents;
+    ConnectedComponents trollComponents;
     Vector2i gridSize;
     Vector3 cubeSize;
     Color defaultCubeColor;
     float height;
+    AStar::SearchOptions searchOptions;
+    double pathfindingTime;     // seconds spent pathfinding since last reset, read by SimulationBench
+    int pathfindingQueries;
+    std::mutex pathfindingMutex; // paths are searched in parallel, guards the statistics and highlightedTiles
 
     MapGenerator();
     ~MapGenerator();
 
-    void draw();
+    DrawCounts draw(const Frustum& frustum);
+    bool isVisible(const Frustum& frustum, BoundingBox bounds); // for objects on the map, after this frame's draw
 
     void generateFromFile(std::string filename);
+    void generateFromTemplate(const MapTemplate& mapTemplate);
 
-    Cube* raycastToGround();
+    MapTile getTile(Vector2i index);
+    Cube getTileCube(Vector2i index);
+    void buildChunkMesh(MapChunk& chunk);
+    std::optional<Cube> raycastToGround(Ray ray);
 
     void recalculateObstacles();
     void recalculateTrollObstacles();
+    void updateObstacleMaps(); // the elf and troll maps and their components, from obstacles
     void addObstacle(Cube cube);
     void removeObstacle(Cube cube);
 
@@ -37,13 +119,14 @@ struct MapGenerator
     Vector2i worldPositionToIndex(Vector3 position);
     Vector3 indexToWorldPosition(Vector2i index);
     Vector3 worldPositionAdjusted(Vector3 position);
-    std::vector<Vector2i> getCubeIndices(Cube& cube);
-    std::vector<Vector2i> getNeighboringIndices(std::vector<Vector2i> indices);
-    std::vector<Vector2i> getNeighboringIndices(Cube cube);
+    // transient, from the frame arena when called inside a tick
+    std::pmr::vector<Vector2i> getCubeIndices(Cube& cube);
+    std::pmr::vector<Vector2i> getNeighboringIndices(const std::pmr::vector<Vector2i>& indices);
+    std::pmr::vector<Vector2i> getNeighboringIndices(Cube cube);
 
-    void colorTiles(std::list<Vector2i> indices);
-    std::vector<Vector3> pathfindPositionsForElf(Vector3 start, Vector3 goal);
-    std::vector<Vector3> pathfindPositionsForTroll(Vector3 start, Vector3 goal);
+    void colorTiles(const GridPath& indices, int scale = 1);
+    Path pathfindPositionsForElf(Vector3 start, Vector3 goal);
+    Path pathfindPositionsForTroll(Vector3 start, Vector3 goal);
 };
 
 #endif
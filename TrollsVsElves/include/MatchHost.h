@@ -0,0 +1,44 @@
+#ifndef MATCH_HOST_H
+#define MATCH_HOST_H
+
+#include <atomic>
+#include <vector>
+
+#include "GameScreen.h"
+#include "NetworkManager.h"
+#include "ThreadPool.h"
+
+struct Match
+{
+    size_t id;
+    unsigned short port;
+    GameScreen* gameScreen;
+    NetworkManager* networkManager;
+    double tickTime = 0;    // seconds spent in the last tick
+};
+
+// Runs many independent server matches in one process, without a window. Every match owns its simulation
+// and listens on a port of its own (basePort + id), the parsed action tree and map templates are shared read-only.
+// Each tick steps all matches in parallel on a thread pool, one task per match polling its network and then
+// updating its simulation, so a match is only ever touched by one thread at a time
+class MatchHost
+{
+private:
+    std::vector<Match> matches;
+    ThreadPool pool;
+    int tickRate;
+
+    void tick();
+    void report(double worstTick, double totalTick, size_t nrOfTicks, size_t overruns);
+
+public:
+    std::atomic<bool> running = true;
+
+    MatchHost() = delete;
+    MatchHost(size_t nrOfMatches, size_t nrOfThreads, unsigned short basePort, int tickRate);
+    ~MatchHost();
+
+    void run(); // blocks until running is cleared
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef NETWORK_CONDITIONER_H
+#define NETWORK_CONDITIONER_H
+
+#include "RakPeerInterface.h"
+#include "BitStream.h"
+#include "PacketPriority.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <vector>
+
+struct ConditionerSettings
+{
+    int latency = 0;            // one way, milliseconds
+    int jitter = 0;             // up to this many extra milliseconds, uniformly distributed
+    float loss = 0.f;           // 0 to 1
+    float duplication = 0.f;    // 0 to 1
+    int bandwidth = 0;          // outgoing bytes per second, 0 for unlimited
+
+    bool isEnabled() const { return latency > 0 || jitter > 0 || loss > 0.f || duplication > 0.f || bandwidth > 0; }
+};
+
+struct ConditionedMessage
+{
+    std::vector<char> data;
+    PacketPriority priority;
+    PacketReliability reliability;
+    RakNet::AddressOrGUID systemIdentifier;
+    bool broadcast;
+};
+
+// Holds outgoing messages back before handing them to RakNet, to test on one machine what a real network would do.
+// Conditions the outgoing direction only, run every process with the same settings to condition both ways.
+// Reliable messages are never lost or duplicated for real, RakNet would resend and deduplicate them, so a loss
+// delays them by a retransmission timeout instead and duplication only applies to unreliable messages
+class NetworkConditioner
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ConditionerSettings settings;
+    std::mt19937 rng;
+    std::multimap<Clock::time_point, ConditionedMessage> pending; // by release time, equal times keep their order
+    Clock::time_point lastOrderedRelease;   // ordered and sequenced messages are never released before an earlier one
+    Clock::time_point bandwidthFreeAt;      // when the simulated uplink has finished sending everything queued so far
+    std::mutex mutex;                       // messages are sent from both the game and the network thread
+
+    bool roll(float chance);
+    void schedule(ConditionedMessage message, Clock::time_point releaseTime);
+
+public:
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<uint64_t> duplicated = 0;
+    std::atomic<uint64_t> retransmitted = 0; // simulated resends of lost reliable messages
+
+    NetworkConditioner();
+
+    void configure(ConditionerSettings settings);
+    ConditionerSettings getSettings();
+    bool isEnabled();
+    size_t getPendingCount();
+
+    void send(const RakNet::BitStream* bs, size_t recipients, PacketPriority priority, PacketReliability reliability, const RakNet::AddressOrGUID systemIdentifier, bool broadcast);
+    void update(RakNet::RakPeerInterface* rakPeerInterface); // hands every message that is due to RakNet
+};
+
+#endif
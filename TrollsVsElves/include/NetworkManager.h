@@ -10,10 +10,17 @@
 
 #include <thread>
 #include <atomic>
+#include <array>
+#include <chrono>
+#include <mutex>
 #include <inttypes.h>
 
 #include "GameScreen.h"
 #include "ThreadSafeMessageQueue.h"
+#include "NetworkStats.h"
+#include "NetworkConditioner.h"
+#include "Logger.h"
+#include "Path.h"
 
 enum GameMessages
 {
@@ -43,12 +50,12 @@ struct SpawnPlayerRequest
 
     void print()
     {
-        printf("SpawnPlayerRequest::print\n");
-        printf("packetType: %d\n", (int)packetType);
-        printf("position: %f, %f, %f\n", position.x, position.y, position.z);
-        printf("type: %d\n", type);
-        printf("networkId: %" PRIu64 "\n", networkId);
-        printf("ownerGuid: %" PRIu64 "\n", ownerGuid);
+        LOG_DEBUG("SpawnPlayerRequest::print");
+        LOG_DEBUG("packetType: %d", (int)packetType);
+        LOG_DEBUG("position: %f, %f, %f", position.x, position.y, position.z);
+        LOG_DEBUG("type: %d", type);
+        LOG_DEBUG("networkId: %" PRIu64, networkId);
+        LOG_DEBUG("ownerGuid: %" PRIu64, ownerGuid);
     }
 };
 
@@ -69,10 +76,10 @@ struct PlayerRMBRequest
 
     void print()
     {
-        printf("PlayerRMBRequest::print\n");
-        printf("packetType: %d\n", (int)packetType);
-        printf("networkId: %" PRIu64 "\n", networkId);
-        printf("position: %f, %f, %f\n", position.x, position.y, position.z);
+        LOG_DEBUG("PlayerRMBRequest::print");
+        LOG_DEBUG("packetType: %d", (int)packetType);
+        LOG_DEBUG("networkId: %" PRIu64, networkId);
+        LOG_DEBUG("position: %f, %f, %f", position.x, position.y, position.z);
     }
 };
 
@@ -81,14 +88,14 @@ struct PlayerPathCorrection
     RakNet::MessageID packetType;
     RakNet::NetworkID networkId;
     size_t nrOfPaths;
-    std::vector<Vector3> path;
+    Path path;
 
     void serialize(bool writeToBitstream, RakNet::BitStream *bs)
     {
         bs->Serialize(writeToBitstream, packetType);
         bs->Serialize(writeToBitstream, networkId);
         bs->Serialize(writeToBitstream, nrOfPaths);
-        if (!writeToBitstream) path = std::vector<Vector3>(nrOfPaths, { 0 });
+        if (!writeToBitstream) path.resize(nrOfPaths);
         for (int i = 0; i < nrOfPaths; i++)
         {
             bs->Serialize(writeToBitstream, path[i].x);
@@ -99,16 +106,27 @@ struct PlayerPathCorrection
 
     void print()
     {
-        printf("PlayerPathCorrection::print\n");
-        printf("packetType: %d\n", (int)packetType);
-        printf("networkId: %" PRIu64 "\n", networkId);
+        LOG_DEBUG("PlayerPathCorrection::print");
+        LOG_DEBUG("packetType: %d", (int)packetType);
+        LOG_DEBUG("networkId: %" PRIu64, networkId);
+#if LOG_MIN_LEVEL <= 1 // the loop only feeds LOG_DEBUG, don't leave it behind when that is compiled out
         for (Vector3 position: path)
-            printf("position: %f, %f, %f\n", position.x, position.y, position.z);
+            LOG_DEBUG("position: %f, %f, %f", position.x, position.y, position.z);
+#endif
     }
 };
 
 enum NetworkType { NONE = 0, SERVER, CLIENT };
 
+// Per message id counters, written by whichever thread sends or receives
+struct MessageCounters
+{
+    std::atomic<uint64_t> messagesIn = 0;
+    std::atomic<uint64_t> bytesIn = 0;
+    std::atomic<uint64_t> messagesOut = 0;
+    std::atomic<uint64_t> bytesOut = 0;
+};
+
 struct NetworkManager
 {
     RakNet::RakPeerInterface* rakPeerInterface;
@@ -120,6 +138,18 @@ struct NetworkManager
     std::atomic<bool> running = true;
     GameScreen* gameScreen = nullptr;
     ThreadSafeMessageQueue messageQueue;
+    NetworkConditioner conditioner;
+
+    std::array<MessageCounters, 256> messageCounters;
+    std::array<MessageStats, 256> previousMessageStats; // last sample, for the rates
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point lastStatsSample;
+    std::chrono::steady_clock::time_point lastStatsDump;
+    NetworkStats stats;
+    std::mutex statsMutex;
+    bool showStatsOverlay = false;
+
+    std::vector<SpawnPlayerRequest> unpublishedSpawns; // server, players handed to the game thread that no snapshot has yet
 
     NetworkManager() = delete;
     NetworkManager(NetworkType networkType, size_t port, GameScreen* gameScreen);
@@ -127,14 +157,25 @@ struct NetworkManager
 
     bool isClient() { return networkType == NetworkType::CLIENT; }
     unsigned char getPacketIdentifier(RakNet::Packet* packet);
-    std::string getPacketName(RakNet::Packet* packet);
-    void listen();
+    unsigned char getPacketIdentifier(const unsigned char* data); // outgoing bitstreams too, skips the timestamp
+    const char* getPacketName(RakNet::Packet* packet);
+    const char* getMessageName(unsigned char id);
+    void listen();      // runs poll until stopped, on a thread of its own
+    void poll();        // one pass over queued messages and received packets, a match host calls it from its tick
+    void shutdown();
+
+    // every outgoing message goes through here so it is counted
+    void send(RakNet::BitStream* bs, PacketPriority priority, PacketReliability reliability, const RakNet::AddressOrGUID systemIdentifier, bool broadcast);
+    void countIncoming(RakNet::Packet* packet);
+    void sampleStats();
+    void dumpStats(const NetworkStats& stats);
+    NetworkStats getStats();
 
     void handleNewIncomingConnection(RakNet::Packet* packet);
     void handleSpawnPlayer(RakNet::Packet* packet);
 
     void handlePlayerPathCorrection(RakNet::Packet* packet);
-    void sendPlayerPathCorrection(Player* player, std::vector<Vector3> path);
+    void sendPlayerPathCorrection(Player* player, Path path);
 
     void handlePlayerRMBRequest(RakNet::Packet* packet);
     void sendPlayerRMBRequest(Player* player, Vector3 position);
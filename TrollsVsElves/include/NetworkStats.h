@@ -0,0 +1,59 @@
+#ifndef NETWORK_STATS_H
+#define NETWORK_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Snapshot of the network state, sampled by the network thread and read by the debug panel and the stats dump
+
+struct ConnectionStats
+{
+    std::string address;
+    int lastPing = 0;                       // round trip, milliseconds
+    int averagePing = 0;
+    int lowestPing = 0;
+    uint64_t bytesSentPerSecond = 0;        // actual bytes on the wire, RakNet headers, acks and resends included
+    uint64_t bytesReceivedPerSecond = 0;
+    uint64_t bytesSentTotal = 0;
+    uint64_t bytesReceivedTotal = 0;
+    uint64_t bytesResentPerSecond = 0;
+    uint64_t bytesResentTotal = 0;
+    unsigned int messagesInResendBuffer = 0;
+    float packetLoss = 0.f;                 // last second, 0 to 1
+};
+
+struct MessageStats
+{
+    int id = 0;
+    std::string name;
+    uint64_t messagesIn = 0;                // totals since startup, payload bytes as handed to or received from RakNet
+    uint64_t bytesIn = 0;
+    uint64_t messagesOut = 0;
+    uint64_t bytesOut = 0;
+    double messagesInPerSecond = 0.0;
+    double messagesOutPerSecond = 0.0;
+    double bytesInPerSecond = 0.0;
+    double bytesOutPerSecond = 0.0;
+};
+
+struct NetworkStats
+{
+    double uptime = 0.0;            // seconds
+    std::vector<ConnectionStats> connections;
+    std::vector<MessageStats> messages; // only ids that have been sent or received
+    size_t networkQueueDepth = 0;   // tasks waiting for the network thread
+    size_t networkQueueHighWater = 0;
+    size_t gameQueueDepth = 0;      // tasks waiting for the game thread
+    size_t gameQueueHighWater = 0;
+    uint64_t tick = 0;              // of the last world snapshot the game thread published
+    size_t nrOfPlayers = 0;
+    size_t nrOfBuildings = 0;
+    bool conditionerEnabled = false;
+    size_t conditionerPending = 0;  // messages held back by the network conditioner
+    uint64_t conditionerDropped = 0;
+    uint64_t conditionerDuplicated = 0;
+    uint64_t conditionerRetransmitted = 0;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "structs.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Waypoints in one contiguous buffer. The pathfinder fills it back to front, it finds a path from the goal
+// backwards, and whoever walks it consumes it front to back, neither end shifts the points. Moved from the search
+// to the entity that walks it, copied only where a path really has a second owner, e.g. a network message
+template<typename T, typename Allocator = std::allocator<T>>
+class PathBuffer
+{
+private:
+    std::vector<T, Allocator> points;
+    size_t first = 0; // points before it are room for pushFront or were walked already
+
+public:
+    PathBuffer() = default;
+    explicit PathBuffer(const Allocator& allocator): points(allocator) {}
+
+    PathBuffer(const PathBuffer& other) = default;
+    PathBuffer& operator=(const PathBuffer& other) = default;
+
+    // the moved-from buffer is left empty, a defaulted move would keep its offset into points it no longer has
+    PathBuffer(PathBuffer&& other) noexcept
+        : points(std::move(other.points)), first(std::exchange(other.first, 0))
+    {
+        other.points.clear();
+    }
+
+    PathBuffer& operator=(PathBuffer&& other) // not noexcept, a pmr vector copies when the resources differ
+    {
+        points = std::move(other.points);
+        first = std::exchange(other.first, 0);
+        other.points.clear();
+        return *this;
+    }
+
+    // a plain copy of a pmr path would go to the default resource, this one stays where it is told
+    PathBuffer(const PathBuffer& other, const Allocator& allocator)
+        : points(other.begin(), other.end(), allocator) {}
+
+    void reserveFront(size_t count) // room for count pushFront calls without moving anything
+    {
+        if (first >= count)
+            return;
+
+        size_t grow = count - first;
+        points.insert(points.begin(), grow, T());
+        first += grow;
+    }
+
+    void pushFront(T point)
+    {
+        if (first == 0)
+            reserveFront(std::max<size_t>(size(), 8)); // doubles, amortized constant like push_back
+        points[--first] = point;
+    }
+
+    void pushBack(T point)          { points.push_back(point); }
+    void popFront()                 { assert(!empty()); first++; } // SANITY
+    void resize(size_t count)       { points.resize(first + count); }
+    void clear()                    { points.clear(); first = 0; }
+
+    size_t size() const             { return points.size() - first; }
+    bool empty() const              { return points.size() == first; }
+
+    T& front()                      { assert(!empty()); return points[first]; }
+    T& back()                       { assert(!empty()); return points.back(); }
+    const T& front() const          { assert(!empty()); return points[first]; }
+    const T& back() const           { assert(!empty()); return points.back(); }
+    T& operator[](size_t i)         { return points[first + i]; }
+    const T& operator[](size_t i) const { return points[first + i]; }
+
+    T* begin()                      { return points.data() + first; }
+    T* end()                        { return points.data() + points.size(); }
+    const T* begin() const          { return points.data() + first; }
+    const T* end() const            { return points.data() + points.size(); }
+};
+
+using GridPath = PathBuffer<Vector2i, std::pmr::polymorphic_allocator<Vector2i>>; // tiles, from the frame arena during a tick
+using Path = PathBuffer<Vector3>; // world positions
+
+#endif
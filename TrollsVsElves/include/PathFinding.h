@@ -1,14 +1,42 @@
 #pragma once
 
 #include "structs.h"
-#include "MapGenerator.h"
 #include "limits.h"
-#include <list>
+#include "Path.h"
+#include <cstdint>
+#include <memory_resource>
 #include <unordered_map>
+#include <unordered_set>
 #include <queue>
 
 namespace AStar
 {
+    constexpr float DIAGONAL_COST = 1.41421356f;
+
+    enum SearchVariant {
+        SEARCH_ASTAR = 0,           // optimal, f = g + h
+        SEARCH_BIDIRECTIONAL,       // optimal, searches from both ends and stops when the frontiers meet
+        SEARCH_WEIGHTED,            // bounded-suboptimal, f = g + w * h
+        SEARCH_CONVEX_UPWARD,       // bounded-suboptimal, pwXU style priority (see weightedConvexUpwardParabola)
+        SEARCH_CONVEX_DOWNWARD      // bounded-suboptimal, pwXD style priority (see weightedConvexDownwardParabola)
+    };
+
+    struct SearchOptions
+    {
+        SearchVariant variant = SEARCH_ASTAR;
+        double weight = 2.0;        // suboptimality bound, only used by the bounded-suboptimal variants
+        int maxExpansions = 0;      // 0 means unlimited, otherwise the best partial path is returned once exceeded
+        bool smoothPath = false;    // string-pull the result so only corner waypoints remain
+    };
+
+    struct SearchStats
+    {
+        int expansions = 0;
+        bool found = false;         // goal was reached
+        bool partial = false;       // budget ran out, path leads to the expanded node closest to the goal, or when
+                                    // the bidirectional frontiers had met, to the goal through the best meeting point
+    };
+
     struct Node
     {
         float g = 0;
@@ -26,13 +54,17 @@ namespace AStar
 
         void print(std::string prefix)
         {
-            printf("%s: x: %d, y: %d\tg: %f, h: %f, f: %f\n", prefix.c_str(), pos.x, pos.y, g, h, f);
+            LOG_DEBUG("%s: x: %d, y: %d\tg: %f, h: %f, f: %f", prefix.c_str(), pos.x, pos.y, g, h, f);
         }
     };
 
     struct HashVector2i
     {
-        std::size_t operator()(const Vector2i& pos) const { return std::hash<int>()(pos.x) ^ std::hash<int>()(pos.y); }
+        // both coordinates packed into one key, x ^ y put whole diagonals of the grid in one bucket
+        std::size_t operator()(const Vector2i& pos) const
+        {
+            return std::hash<uint64_t>()((uint64_t(uint32_t(pos.x)) << 32) | uint32_t(pos.y));
+        }
     };
 
     struct CompareNode
@@ -40,8 +72,33 @@ namespace AStar
         bool operator() (const Node& lhs, const Node& rhs) const { return lhs.f > rhs.f; }
     };
 
-    double weightedConvexUpwardParabola(double g, double h);
-    double weightedConvexDownwardParabola(double g, double h);
-    std::list<Vector2i> backtrack(std::unordered_map<Vector2i, Node, HashVector2i>& nodes, Node& start, Node node);
-    std::list<Vector2i> findPath(Vector2i start, Vector2i goal, const std::vector<std::vector<bool>>& obstacles);
+    float octileDistance(Vector2i from, Vector2i to);
+    double weightedConvexUpwardParabola(double g, double h, double weight = 2.0);
+    double weightedConvexDownwardParabola(double g, double h, double weight = 2.0);
+    double priority(double g, double h, const SearchOptions& options);
+    GridPath backtrack(std::pmr::unordered_map<Vector2i, Node, HashVector2i>& nodes, Node& start, Node node);
+    bool hasLineOfSight(Vector2i from, Vector2i to, const std::vector<std::vector<bool>>& obstacles);
+    GridPath smoothPath(Vector2i start, const GridPath& path, const std::vector<std::vector<bool>>& obstacles);
+    // the path and every container of the search come from the frame arena while a scope is open
+    GridPath findPath(
+        Vector2i start,
+        Vector2i goal,
+        const std::vector<std::vector<bool>>& obstacles,
+        const SearchOptions& options = SearchOptions(),
+        SearchStats* stats = nullptr
+    );
+    GridPath findPathUnidirectional(
+        Vector2i start,
+        Vector2i goal,
+        const std::vector<std::vector<bool>>& obstacles,
+        const SearchOptions& options,
+        SearchStats& stats
+    );
+    GridPath findPathBidirectional(
+        Vector2i start,
+        Vector2i goal,
+        const std::vector<std::vector<bool>>& obstacles,
+        const SearchOptions& options,
+        SearchStats& stats
+    );
 }
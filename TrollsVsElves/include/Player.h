@@ -3,9 +3,11 @@
 
 #include "Entity.h"
 #include "ActionsManager.h"
+#include "SlotMap.h"
 
 #include "NetworkIDObject.h"
 
+#include <deque>
 #include <map>
 #include <functional>
 
@@ -16,10 +18,12 @@ enum PlayerType { PLAYER_ELF, PLAYER_TROLL };
 struct Player : public Entity, public RakNet::NetworkIDObject
 {
     BuildingManager* buildingManager;
+    std::vector<SlotHandle> buildings; // owned, in the order they were placed, kept up to date by the BuildingManager
+    std::deque<SlotHandle> buildQueue; // scheduled, in the order they get built
 
-    std::string actionId;
-    std::string originalActionId;
-    std::string previousActionId;
+    ActionId actionId;
+    ActionId originalActionId;
+    ActionId previousActionId;
 
     PlayerType playerType;
 
@@ -27,7 +31,7 @@ struct Player : public Entity, public RakNet::NetworkIDObject
     Player(Vector3 position, PlayerType playerType);
     ~Player();
 
-    void draw();
+    void draw(InstancedRenderer& renderer);
     std::vector<ActionNode> getActions(int nrOfButtons);
     void update();
 
@@ -3,34 +3,65 @@
 
 #include "BuildingManager.h"
 #include "Player.h"
+#include "ScreenGrid.h"
+#include "SelectionSet.h"
 #include "utils.h"
 #include "constants.h"
 
+#include <functional>
+
+// Where a player's capsule is on screen, the circles around its two end spheres
+struct ScreenCapsule
+{
+    Circle bottom;
+    Circle top;
+};
+
+// A path to find for a player, requests are searched together and in parallel at the start of the next update
+struct PathRequest
+{
+    Player* player;
+    Vector3 position;
+    std::function<void(const Path& path)> onResolved; // optional, called once the player has the path
+};
+
 struct PlayerManager
 {
     BuildingManager* buildingManager;
     MapGenerator* mapGenerator;
+    CameraManager* cameraManager;
 
     std::vector<Player*> players;
-    Player* selectedPlayer;
+    SelectionSet selection;
+    Player* selectedPlayer; // the first one selected, its actions are shown in the action window
     Player* clientPlayer;
+    std::vector<ScreenCapsule> screenCapsules; // by player index, projected once a frame for picking, selection and overlays
+    ScreenGrid screenGrid;  // buckets screenCapsules, rebuilt on the first query after the projection
+    bool screenGridDirty;
+    std::vector<PathRequest> pathRequests;
 
     PlayerManager() = delete;
-    PlayerManager(BuildingManager* buildingManager, MapGenerator* mapGenerator);
+    PlayerManager(BuildingManager* buildingManager, MapGenerator* mapGenerator, CameraManager* cameraManager);
     ~PlayerManager();
 
-    void draw();
+    DrawCounts draw(const Frustum& frustum, InstancedRenderer& renderer);
     void update();
     void addPlayer(Player* player);
-    void select(Player* player);
-    void deselect();
+    void select(Player* player); // adds to the selection
+    void deselect(); // the whole selection
 
     Vector3 calculateTargetPositionToCubeFromPlayer(Player* player, Cube cube);
-    bool checkCollisionCapsulePoint(Capsule capsule, Vector2 point);
+    void updateScreenCapsules();
+    bool checkCollisionCapsulePoint(const ScreenCapsule& capsule, Vector2 point);
+    bool checkCollisionCapsuleRec(const ScreenCapsule& capsule, Rectangle rectangle);
+    void updateScreenGrid();
 
-    std::vector<Vector3> pathfindPlayerToPosition(Player* player, Vector3 position);
+    Path findPath(Player* player, Vector3 position); // safe to call from several threads at once
+    void requestPath(Player* player, Vector3 position, std::function<void(const Path& path)> onResolved = nullptr);
+    void resolvePathRequests(); // in request order, when a player has several the last one wins
 
     Player* raycastToPlayer();
+    std::vector<Player*> getPlayersInRectangle(Rectangle rectangle); // in screen space
     Player* getPlayerWithNetworkID(RakNet::NetworkID networkID);
 };
 
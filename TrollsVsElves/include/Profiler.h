@@ -0,0 +1,104 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Zones are recorded in Debug, and in Release only when built with ENABLE_PROFILER (premake5 --profiler).
+// Otherwise the macros expand to nothing and nothing is recorded
+#if defined(DEBUG) || defined(ENABLE_PROFILER)
+    #define PROFILER_ENABLED
+#endif
+
+struct ProfileEvent
+{
+    const char* name;   // only the pointer is stored, zone names must be string literals
+    uint64_t start;     // nanoseconds since the profiler was created
+    uint64_t end;
+    uint32_t depth;     // nesting level within the thread, 0 for outermost zones
+};
+
+// Ring buffer slot, relaxed atomics so the overlay can read slots the owning thread is overwriting
+struct ProfileSlot
+{
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> end;
+    std::atomic<uint32_t> depth;
+};
+
+// Every thread writes to its own ring buffer, so recording a zone never takes a lock
+struct ProfileThread
+{
+    static constexpr uint64_t CAPACITY = 1 << 15;
+
+    std::string name;
+    uint32_t id;
+    uint32_t depth;
+    std::vector<ProfileSlot> slots;
+    std::atomic<uint64_t> written;  // total number of events ever written, the ring keeps the last CAPACITY
+
+    ProfileThread(uint32_t id);
+
+    void push(const ProfileEvent& event);
+};
+
+class Profiler
+{
+private:
+    Profiler();
+
+    std::chrono::steady_clock::time_point epoch;
+    std::mutex mutex;                       // only guards the list of threads, taken once per thread and by readers
+    std::vector<ProfileThread*> threads;    // never freed, threads may record zones until the process exits
+
+public:
+    bool showOverlay;
+    bool paused;
+    uint64_t pausedAt;
+    float statsWindow;      // seconds aggregated in the zone table
+    float timelineWindow;   // seconds shown in the timeline
+
+    static Profiler& get()
+    {
+        static Profiler instance;
+        return instance;
+    }
+
+    uint64_t now();
+    ProfileThread& getThread(); // registers the calling thread on first use
+    void setThreadName(std::string name);
+    std::vector<ProfileThread*> getThreads();
+
+    // copies the events of a thread that ended after since, events overwritten during the copy are dropped
+    std::vector<ProfileEvent> collect(ProfileThread& thread, uint64_t since = 0);
+
+    // writes every buffered event in the Chrome trace event format, open with chrome://tracing or ui.perfetto.dev
+    bool exportChromeTrace(std::string filename);
+};
+
+struct ProfileZone
+{
+    ProfileThread& thread;
+    const char* name;
+    uint64_t start;
+
+    ProfileZone(const char* name);
+    ~ProfileZone();
+};
+
+#ifdef PROFILER_ENABLED
+    #define PROFILE_CONCAT_INNER(a, b) a##b
+    #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+    #define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+    #define PROFILE_THREAD(name) Profiler::get().setThreadName(name)
+#else
+    #define PROFILE_ZONE(name)
+    #define PROFILE_THREAD(name)
+#endif
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SCREEN_GRID_H
+#define SCREEN_GRID_H
+
+#include "raylib.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Buckets screen-space bounds into square cells so rectangle and point queries only look at items nearby.
+// Rebuilt from scratch whenever the bounds change, items are laid out per cell in one array (CSR)
+class ScreenGrid
+{
+private:
+    float cellSize;
+    int columns;
+    int rows;
+    std::vector<uint32_t> cellOffsets;  // items of cell i are items[cellOffsets[i]..cellOffsets[i + 1]]
+    std::vector<uint32_t> items;        // indices into the bounds the grid was built from
+    std::vector<uint32_t> queryStamps;  // per item, the last query that returned it, to return items once
+    uint32_t queryStamp;
+
+    void getCellRange(Rectangle area, int& minColumn, int& minRow, int& maxColumn, int& maxRow);
+
+public:
+    ScreenGrid(float cellSize);
+
+    void build(const std::pmr::vector<Rectangle>& bounds, Vector2 screenSize); // bounds outside the screen are left out
+    std::pmr::vector<uint32_t> query(Rectangle area); // items whose cells overlap the area, sorted, test them precisely. From the frame arena
+};
+
+#endif
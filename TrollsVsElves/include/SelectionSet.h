@@ -0,0 +1,29 @@
+#ifndef SELECTION_SET_H
+#define SELECTION_SET_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+struct Player; // forward declaration
+
+// The selected units, in the order they were selected. Adding and membership checks are O(1)
+class SelectionSet
+{
+private:
+    std::vector<Player*> members;
+    std::unordered_map<Player*, size_t> indices; // into members
+
+public:
+    bool add(Player* player); // false if it was already selected
+    bool remove(Player* player);
+    bool contains(Player* player) const;
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+    Player* front() const; // nullptr when empty
+    const std::vector<Player*>& getMembers() const;
+};
+
+#endif
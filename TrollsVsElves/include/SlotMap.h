@@ -0,0 +1,113 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Refers to a value in a SlotMap. Stays valid until that value is removed, a handle to a removed value never
+// resolves again, not even when its slot is reused
+struct SlotHandle
+{
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != INVALID_INDEX; }
+    bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Values are packed in one array for iteration, slots map handles to them. Insert, remove and lookup are O(1),
+// removing swaps the last value into the hole, so pointers and dense indices only last until the next removal
+template<typename T>
+class SlotMap
+{
+private:
+    struct Slot
+    {
+        uint32_t valueIndex;
+        uint32_t generation;
+    };
+
+    std::vector<T> values;
+    std::vector<uint32_t> valueSlots; // by value index, the slot pointing at it
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+public:
+    SlotHandle insert(T value)
+    {
+        uint32_t slotIndex;
+        if (freeSlots.size())
+        {
+            slotIndex = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            slotIndex = slots.size();
+            slots.push_back({ 0, 0 });
+        }
+
+        slots[slotIndex].valueIndex = values.size();
+        values.push_back(std::move(value));
+        valueSlots.push_back(slotIndex);
+
+        return { slotIndex, slots[slotIndex].generation };
+    }
+
+    bool remove(SlotHandle handle)
+    {
+        if (!contains(handle))
+            return false;
+
+        Slot& slot = slots[handle.index];
+        uint32_t last = values.size() - 1;
+        if (slot.valueIndex != last)
+        {
+            values[slot.valueIndex] = std::move(values[last]);
+            valueSlots[slot.valueIndex] = valueSlots[last];
+            slots[valueSlots[last]].valueIndex = slot.valueIndex;
+        }
+        values.pop_back();
+        valueSlots.pop_back();
+
+        slot.generation++; // outstanding handles to this slot no longer resolve
+        freeSlots.push_back(handle.index);
+        return true;
+    }
+
+    bool contains(SlotHandle handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    T* get(SlotHandle handle)
+    {
+        return contains(handle) ? &values[slots[handle.index].valueIndex] : nullptr;
+    }
+
+    const T* get(SlotHandle handle) const
+    {
+        return contains(handle) ? &values[slots[handle.index].valueIndex] : nullptr;
+    }
+
+    // dense access, for iterating and removing while iterating
+    T& at(size_t valueIndex)                        { assert(valueIndex < values.size()); return values[valueIndex]; }
+    SlotHandle getHandle(size_t valueIndex) const   { return { valueSlots[valueIndex], slots[valueSlots[valueIndex]].generation }; }
+
+    size_t size() const                             { return values.size(); }
+    bool empty() const                              { return values.empty(); }
+    void reserve(size_t capacity)                   { values.reserve(capacity); valueSlots.reserve(capacity); slots.reserve(capacity); }
+
+    typename std::vector<T>::iterator begin()               { return values.begin(); }
+    typename std::vector<T>::iterator end()                 { return values.end(); }
+    typename std::vector<T>::const_iterator begin() const   { return values.begin(); }
+    typename std::vector<T>::const_iterator end() const     { return values.end(); }
+};
+
+#endif
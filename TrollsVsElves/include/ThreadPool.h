@@ -0,0 +1,36 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeMessageQueue.h"
+
+// Fixed number of worker threads running submitted tasks in any order
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::queue<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable finished;
+    size_t unfinished;  // submitted tasks that haven't returned yet
+    bool stopping;
+
+    void work(size_t index);
+
+public:
+    ThreadPool() = delete;
+    ThreadPool(size_t nrOfThreads);
+    ~ThreadPool();
+
+    size_t size();
+    void submit(Task task);
+    void wait(); // blocks until every task submitted so far has finished
+};
+
+#endif
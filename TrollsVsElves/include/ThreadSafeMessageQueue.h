@@ -12,6 +12,7 @@ class ThreadSafeMessageQueue
 private:
     std::queue<Task> messageQueue;
     std::mutex mutex;
+    size_t highWaterMark;
 
 public:
     ThreadSafeMessageQueue();
@@ -19,6 +20,9 @@ public:
 
     void push(Task task);
     bool pop(Task& task);
+
+    size_t size();
+    size_t takeHighWaterMark(); // deepest the queue has been since the last call
 };
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef TILED_MAP_READER_H
+#define TILED_MAP_READER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct MapTemplate; // forward declaration, defined in MapGenerator.h
+
+// Reads a Tiled json map straight into a MapTemplate without building a json document. The file is read in
+// fixed size chunks and everything but the map size and the tile layers is skipped, so apart from the result
+// only one layer is held at a time. Layer data can be a plain array or base64, optionally zlib or gzip compressed
+class TiledMapReader
+{
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
+    static constexpr uint32_t TILE_FLAGS = 0xF0000000; // flip and rotation bits of a tile id
+
+    std::ifstream file;
+    std::vector<char> buffer;
+    size_t position;        // next byte in the buffer
+    size_t end;             // bytes in the buffer
+    size_t offset;          // bytes of the file before the buffer, for error messages
+    std::string error;
+
+    int peek();             // -1 at the end of the file
+    int next();
+    void skipWhitespace();
+    bool expect(char c);
+    bool fail(std::string message);
+
+    bool readString(std::string& string);
+    bool readInteger(int64_t& value);
+    bool skipValue(int depth = 0);
+
+    bool readLayer(MapTemplate& mapTemplate);
+    bool readTileArray(std::vector<int32_t>& tiles);
+    bool readBase64(std::vector<uint8_t>& bytes);
+    bool decodeTiles(const std::vector<uint8_t>& bytes, const std::string& compression, std::vector<int32_t>& tiles);
+
+public:
+    TiledMapReader();
+
+    bool read(std::string filename, MapTemplate& mapTemplate);
+    const std::string& getError();
+};
+
+#endif
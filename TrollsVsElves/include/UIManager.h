@@ -1,12 +1,20 @@
 #pragma once
 
 #include "ActionsManager.h"
+#include "InputManager.h"
+#include "Profiler.h"
+#include "NetworkStats.h"
 #include "rlImGui.h"
 #include "imgui.h"
 
+#include <functional>
+
 namespace UIManager
 {
     int pushButtonDisabled();
     int pushButtonEnabled();
-    void drawActionButtons(std::vector<ActionNode>& actions, Vector2i screenSize);
+    void drawActionButtons(const std::vector<ActionNode>& actions, Vector2i screenSize);
+    void drawProfiler(Profiler& profiler); // toggled with F1
+    void drawNetworkStats(std::function<NetworkStats()> getStats, bool& show); // toggled with F2, only samples while shown
+    void drawCullingStats(const CullingStats& stats, bool& show); // toggled with F3
 };
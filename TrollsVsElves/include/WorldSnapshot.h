@@ -0,0 +1,59 @@
+#ifndef WORLD_SNAPSHOT_H
+#define WORLD_SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Player.h"
+
+struct PlayerSnapshot
+{
+    RakNet::NetworkID networkId;
+    PlayerType type;
+    Vector3 position;
+};
+
+// The replicable state at the end of a tick, never changed once published
+struct WorldSnapshot
+{
+    uint64_t tick = 0;
+    std::vector<PlayerSnapshot> players;
+    size_t nrOfBuildings = 0;
+};
+
+// Two snapshots, the game thread publishes one while other threads read the other. Reading never blocks or locks,
+// a reader pins the current snapshot with a reader count. The game thread only writes the snapshot nobody
+// reads, and waits for stragglers that still hold it from two publishes ago
+class WorldSnapshotBuffer
+{
+private:
+    WorldSnapshot snapshots[2];
+    std::atomic<uint32_t> readers[2];
+    std::atomic<int> front; // the snapshot new readers get
+
+public:
+    class Reader
+    {
+    private:
+        WorldSnapshotBuffer* buffer;
+        int index;
+
+    public:
+        Reader(WorldSnapshotBuffer* buffer, int index) : buffer(buffer), index(index) {}
+        Reader(Reader&& other) : buffer(other.buffer), index(other.index) { other.buffer = nullptr; }
+        Reader(const Reader&) = delete;
+        ~Reader() { if (buffer) buffer->readers[index].fetch_sub(1); }
+
+        const WorldSnapshot& get() const { return buffer->snapshots[index]; }
+        const WorldSnapshot* operator->() const { return &get(); }
+    };
+
+    WorldSnapshotBuffer();
+
+    WorldSnapshot& beginPublish(); // the game thread only, the snapshot to fill in
+    void endPublish();
+    Reader read(); // any thread, keep the reader short lived, the game thread waits for it two publishes later
+};
+
+#endif
@@ -1,5 +1,20 @@
+#pragma once
 
 namespace constants
 {
     constexpr size_t MAX_PLAYERS { 4 };
+    constexpr int PATHFINDING_MAX_EXPANSIONS { 4096 };
+    constexpr int NETWORK_STATS_INTERVAL_MS { 1000 };       // how often the network thread samples statistics
+    constexpr int NETWORK_STATS_DUMP_INTERVAL_S { 10 };     // how often they are written to the log, 0 to disable
+    constexpr int MATCH_HOST_TICK_RATE { 60 };              // simulation ticks per second of every hosted match
+    constexpr int MATCH_HOST_REPORT_INTERVAL_S { 10 };      // how often the match host logs its tick times
+    constexpr int MAP_CHUNK_SIZE { 32 };                    // tiles along each side of a map chunk
+    constexpr int MAP_CHUNK_MESHES_PER_FRAME { 4 };         // chunk meshes built per frame at most, spreads out the cost
+    constexpr int MAP_CHUNK_CULLING_MARGIN { 4 };           // cubes a building or unit may stick out of the chunk it stands in
+    constexpr size_t JOB_PLAYERS_PER_JOB { 64 };            // players moved per job, fewer run on the calling thread
+    constexpr size_t JOB_BUILDINGS_PER_JOB { 256 };         // building timers advanced per job
+    constexpr size_t JOB_PATHS_PER_JOB { 1 };               // path requests per job, every one is a full search
+    constexpr size_t FRAME_ARENA_INITIAL_SIZE { 64 * 1024 }; // bytes of every thread's frame arena, grows to what a tick needs
+    constexpr float SELECTION_GRID_CELL_SIZE { 64.f };      // pixels along each side of a cell of the screen-space selection grid
+    constexpr const char* GAME_DATA_BUNDLE_FILENAME { "gamedata.bin" }; // written by GameDataCooker, optional
 }
\ No newline at end of file
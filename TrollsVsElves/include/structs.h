@@ -3,6 +3,7 @@
 #include "raylib.h"
 #include "raymath.h"
 #include "utils.h"
+#include "Logger.h"
 #include <cmath>
 #include <cassert>
 #include <string>
@@ -88,6 +89,15 @@ inline void drawCapsule(Capsule capsule)
     DrawCapsuleWires(capsule.startPos, capsule.endPos, capsule.radius, capsule.slices, capsule.rings, GRAY);
 }
 
+inline BoundingBox getCapsuleBoundingBox(Capsule capsule)
+{
+    Vector3 radius = { capsule.radius, capsule.radius, capsule.radius };
+    return {
+        Vector3Subtract(Vector3Min(capsule.startPos, capsule.endPos), radius),
+        Vector3Add(Vector3Max(capsule.startPos, capsule.endPos), radius)
+    };
+}
+
 struct Vector2i
 {
     int x = 0;
@@ -101,7 +111,7 @@ struct Vector2i
 
 inline void printVector2i(std::string prefix, Vector2i vec)
 {
-    printf("%s: %d, %d\n", prefix.c_str(), vec.x, vec.y);
+    LOG_DEBUG("%s: %d, %d", prefix.c_str(), vec.x, vec.y);
 }
 
 struct Item
@@ -119,4 +129,57 @@ struct Circle
 
     Circle() {};
     Circle(float _radius, Vector2 _position): radius(_radius), position(_position) {};
-};
\ No newline at end of file
+};
+
+// The six planes of a camera's view volume, normals point inwards (a * x + b * y + c * z + d >= 0 inside)
+struct Frustum
+{
+    Vector4 planes[6];
+
+    Frustum() {};
+
+    // from a combined view projection matrix, as raylib multiplies them (view first)
+    Frustum(Matrix m)
+    {
+        planes[0] = { m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8,  m.m15 + m.m12 }; // left
+        planes[1] = { m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8,  m.m15 - m.m12 }; // right
+        planes[2] = { m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9,  m.m15 + m.m13 }; // bottom
+        planes[3] = { m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9,  m.m15 - m.m13 }; // top
+        planes[4] = { m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14 }; // near
+        planes[5] = { m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14 }; // far
+    };
+};
+
+// conservative, a box is only rejected when it is completely behind one plane
+inline bool isBoxInFrustum(const Frustum& frustum, BoundingBox box)
+{
+    for (const Vector4& plane: frustum.planes)
+    {
+        // the corner furthest along the plane normal
+        Vector3 corner = {
+            plane.x >= 0.f ? box.max.x : box.min.x,
+            plane.y >= 0.f ? box.max.y : box.min.y,
+            plane.z >= 0.f ? box.max.z : box.min.z
+        };
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.f)
+            return false;
+    }
+
+    return true;
+}
+
+// Objects handed to the renderer and skipped by frustum culling during a draw
+struct DrawCounts
+{
+    int submitted = 0;
+    int culled = 0;
+};
+
+// What frustum culling let through during the last GameScreen::draw()
+struct CullingStats
+{
+    DrawCounts chunks;
+    DrawCounts buildings;
+    DrawCounts players;
+    int instancedDrawCalls = 0;
+};
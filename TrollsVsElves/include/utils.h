@@ -2,6 +2,7 @@
 
 #include "raylib.h"
 #include "structs.h"
+#include "Logger.h"
 #include <cstdio>
 #include <cassert>
 #include <string>
@@ -12,12 +13,12 @@
 
 inline void printVector2(std::string prefix, Vector2 vec)
 {
-    printf("%s: %f, %f\n", prefix.c_str(), vec.x, vec.y);
+    LOG_DEBUG("%s: %f, %f", prefix.c_str(), vec.x, vec.y);
 }
 
 inline void printVector3(std::string prefix, Vector3 vec)
 {
-    printf("%s: %f, %f, %f\n", prefix.c_str(), vec.x, vec.y, vec.z);
+    LOG_DEBUG("%s: %f, %f, %f", prefix.c_str(), vec.x, vec.y, vec.z);
 }
 
 inline void printBoundingBox(std::string prefix, BoundingBox box)
@@ -28,34 +29,29 @@ inline void printBoundingBox(std::string prefix, BoundingBox box)
 
 inline void printMatrix(std::string prefix, Matrix m)
 {
-    std::string out = "";
-    out += std::to_string(m.m0) + ','; out += std::to_string(m.m4) + ','; out += std::to_string(m.m8) + ','; out += std::to_string(m.m12) + ',';
-    out += '\n';
-    out += std::to_string(m.m1) + ','; out += std::to_string(m.m5) + ','; out += std::to_string(m.m9) + ','; out += std::to_string(m.m13) + ',';
-    out += '\n';
-    out += std::to_string(m.m2) + ','; out += std::to_string(m.m6) + ','; out += std::to_string(m.m10) + ','; out += std::to_string(m.m14) + ',';
-    out += '\n';
-    out += std::to_string(m.m3) + ','; out += std::to_string(m.m7) + ','; out += std::to_string(m.m11) + ','; out += std::to_string(m.m15) + ',';
-    out += '\n';
-    printf("%s\n%s\n", prefix.c_str(), out.c_str());
+    LOG_DEBUG("%s", prefix.c_str());
+    LOG_DEBUG("%f,%f,%f,%f,", m.m0, m.m4, m.m8, m.m12);
+    LOG_DEBUG("%f,%f,%f,%f,", m.m1, m.m5, m.m9, m.m13);
+    LOG_DEBUG("%f,%f,%f,%f,", m.m2, m.m6, m.m10, m.m14);
+    LOG_DEBUG("%f,%f,%f,%f,", m.m3, m.m7, m.m11, m.m15);
 }
 
 inline void printColor(std::string prefix, Color color)
 {
-    printf("%s: %u, %u, %u, %u\n", prefix.c_str(), color.r, color.g, color.b, color.a);
+    LOG_DEBUG("%s: %u, %u, %u, %u", prefix.c_str(), color.r, color.g, color.b, color.a);
 }
 
 inline void print2DBoolVector(std::string prefix, std::vector<std::vector<bool>> vec)
 {
-    std::string str = "";
+    LOG_DEBUG("%s", prefix.c_str());
     for (int y = 0; y < vec.size(); y++)
     {
+        std::string str = ""; // one message per row, a whole grid wouldn't fit in a log record
         for (int x = 0; x < vec[y].size(); x++)
             str += vec[y][x] == false ? '0' : '1';
 
-        str += '\n';
+        LOG_DEBUG("%s", str.c_str());
     }
-    printf("%s\n%s\n", prefix.c_str(), str.c_str());
 }
 
 inline float nearestIncrementOld(float value, float increment)
@@ -95,7 +91,8 @@ inline Json::Value parseJsonFile(std::string filename)
     std::ifstream file(filename);
     if (!file.is_open())
     {
-        printf("couldn't open file %s\n", filename.c_str());
+        LOG_ERROR("couldn't open file %s", filename.c_str());
+        Logger::get().flush(); // the assert aborts before the logger could write it
         assert(file.is_open());
     }
 
@@ -106,7 +103,8 @@ inline Json::Value parseJsonFile(std::string filename)
 
     if (!parsingSuccessful)
     {
-        printf("couldn't parse json file %s\n", filename.c_str());
+        LOG_ERROR("couldn't parse json file %s", filename.c_str());
+        Logger::get().flush(); // the assert aborts before the logger could write it
         assert(parsingSuccessful);
     }
 
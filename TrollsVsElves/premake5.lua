@@ -37,10 +37,11 @@ project (baseName)
         ["Source Files/*"] = {"src/**.c", "src/**.cpp","**.c", "**.cpp"},
     }
     files {"**.c", "**.cpp", "**.h", "**.hpp"}
+    removefiles { "src/AllocationCounter.cpp" } -- only the benches replace operator new to count allocations
 
     includedirs { "./", "src", "include", "../extras/RakNet/Source" }
     libdirs { "../extras/RakNet/Lib/Lib/LibStatic" }
-    links { "RakNetLibStatic", "pthread" }
+    links { "RakNetLibStatic", "pthread", "z" }
 
     link_raylib()
     link_to("jsoncpp")
@@ -1,46 +1,186 @@
 #include "ActionsManager.h"
+#include "GameDataBundle.h"
 #include <iostream>
 
-ActionsManager::ActionsManager() {}
+ActionType parseActionType(const std::string& action)
+{
+    if (action == "build")      return ACTION_BUILD;
+    if (action == "promote")    return ACTION_PROMOTE;
+    if (action == "recruit")    return ACTION_RECRUIT;
+    if (action == "buy")        return ACTION_BUY;
+    if (action == "spell")      return ACTION_SPELL;
+    return ACTION_NONE;
+}
+
+ActionsManager::ActionsManager()
+{
+    intern("filler");
+    intern("sell");
+    intern("back");
+    nodes[FILLER_ACTION] = ActionNode(FILLER_ACTION, "filler", "Filler", ACTION_FILLER);
+    nodes[SELL_ACTION] = ActionNode(SELL_ACTION, "sell", "Sell", ACTION_SELL);
+    nodes[BACK_ACTION] = ActionNode(BACK_ACTION, "back", "Back", ACTION_BACK);
+}
 
 ActionsManager::~ActionsManager() {}
 
+void ActionsManager::load(std::string requirementsFilename, std::string actionsFilename)
+{
+    std::call_once(loaded, [&]() {
+        GameDataBundle& bundle = GameDataBundle::get();
+        if (bundle.isOpen() && bundle.isFresh(actionsFilename) && bundle.isFresh(requirementsFilename) && loadBundle(bundle))
+        {
+            LOG_DEBUG("loaded %zu actions from the game data bundle", nodes.size());
+            return;
+        }
+
+        loadActions(actionsFilename);
+        loadRequirements(requirementsFilename);
+        LOG_DEBUG("loaded %zu actions", nodes.size());
+    });
+}
+
+ActionId ActionsManager::intern(const std::string& key)
+{
+    auto found = ids.find(key);
+    if (found != ids.end())
+        return found->second;
+
+    if (nodes.size() >= MAX_ACTIONS)
+    {
+        LOG_ERROR("more than %zu actions, raise MAX_ACTIONS", MAX_ACTIONS);
+        Logger::get().flush();
+        assert(nodes.size() < MAX_ACTIONS);
+    }
+
+    ActionId id = nodes.size();
+    ids.insert({ key, id });
+    nodes.push_back(ActionNode(id, key, "", ACTION_NONE)); // filled in once its own entry is read
+    requirements.push_back(ActionSet());
+    return id;
+}
+
 void ActionsManager::loadRequirements(std::string filename)
 {
     Json::Value json = parseJsonFile(filename);
-    for (const auto& id: json.getMemberNames())
+    for (const auto& key: json.getMemberNames())
     {
-        std::vector<std::string> reqs;
-        for (const auto& req : json[id])
-            reqs.push_back(req.asString());
-
-        requirements.insert({ id, reqs });
+        ActionId id = intern(key);
+        for (const auto& requirement: json[key])
+        {
+            ActionId required = intern(requirement.asString());
+            requirements[id].set(required);
+        }
     }
 }
 
 void ActionsManager::loadActions(std::string filename)
 {
     Json::Value json = parseJsonFile(filename);
-    for (const auto& id: json.getMemberNames())
+
+    // intern every key and child first so the adjacency can be laid out by id
+    std::vector<std::vector<ActionId>> adjacency;
+    for (const auto& key: json.getMemberNames())
     {
-        Json::Value& obj = json[id];
-        std::string name = obj["name"].asString();
-        std::string action = obj["action"].asString();
+        Json::Value& obj = json[key];
+        ActionId id = intern(key);
+        nodes[id].name = obj["name"].asString();
+        nodes[id].type = parseActionType(obj["action"].asString());
 
-        std::vector<std::string> children;
-        for (const auto& child : obj["children"])
-            children.push_back(child.asString());
+        std::vector<ActionId> childIds;
+        for (const auto& child: obj["children"])
+            childIds.push_back(intern(child.asString()));
 
-        actions.insert({ id, ActionNode(id, name, action, children) });
+        adjacency.resize(nodes.size());
+        adjacency[id] = childIds;
     }
+    adjacency.resize(nodes.size());
+
+    childOffsets.clear();
+    children.clear();
+    for (const std::vector<ActionId>& childIds: adjacency)
+    {
+        childOffsets.push_back(children.size());
+        children.insert(children.end(), childIds.begin(), childIds.end());
+    }
+    childOffsets.push_back(children.size());
 }
 
+bool ActionsManager::loadBundle(const GameDataBundle& bundle)
+{
+    const BundleHeader& header = bundle.getHeader();
+    const BundleAction* bundleActions = bundle.getActions();
 
-std::vector<ActionNode> ActionsManager::getActionChildren(std::string id)
+    // the builtin actions are cooked too, they have to have kept their ids
+    for (ActionId id: { FILLER_ACTION, SELL_ACTION, BACK_ACTION })
+    {
+        if (id >= header.nrOfActions || bundle.getString(bundleActions[id].key) != nodes[id].key)
+        {
+            LOG_WARNING("the builtin actions of the game data bundle don't match, recook it");
+            return false;
+        }
+    }
+
+    nodes.clear();
+    ids.clear();
+    requirements.clear();
+    for (ActionId id = 0; id < header.nrOfActions; id++)
+    {
+        const BundleAction& action = bundleActions[id];
+        std::string key = bundle.getString(action.key);
+        nodes.push_back(ActionNode(id, key, bundle.getString(action.name), ActionType(action.type)));
+        ids.insert({ key, id });
+
+        ActionSet required;
+        const uint64_t* words = bundle.getRequirements(id);
+        for (size_t bit = 0; bit < MAX_ACTIONS; bit++)
+            if (words[bit / 64] & (uint64_t(1) << (bit % 64)))
+                required.set(bit);
+        requirements.push_back(required);
+    }
+
+    childOffsets.assign(bundle.getChildOffsets(), bundle.getChildOffsets() + header.nrOfActions + 1);
+    children.assign(bundle.getChildren(), bundle.getChildren() + header.nrOfChildren);
+    return true;
+}
+
+ActionId ActionsManager::getId(const std::string& key) const
+{
+    auto found = ids.find(key);
+    return found != ids.end() ? found->second : NO_ACTION;
+}
+
+const ActionNode& ActionsManager::getNode(ActionId id) const
+{
+    assert(id < nodes.size());
+    return nodes[id];
+}
+
+const std::string& ActionsManager::getKey(ActionId id) const
+{
+    static const std::string unknown = "unknown";
+    return id < nodes.size() ? nodes[id].key : unknown;
+}
+
+size_t ActionsManager::size() const
+{
+    return nodes.size();
+}
+
+std::vector<ActionNode> ActionsManager::getActionChildren(ActionId id) const
 {
     std::vector<ActionNode> childActions;
-    for (const auto& id: actions[id].children)
-        childActions.push_back(actions[id]);
+    if (id + size_t(1) >= childOffsets.size()) // unknown, or interned after the action tree was laid out
+        return childActions;
+
+    for (uint32_t i = childOffsets[id]; i < childOffsets[id + 1]; i++)
+        childActions.push_back(nodes[children[i]]);
 
     return childActions;
 }
+
+const ActionSet& ActionsManager::getRequirements(ActionId id) const
+{
+    static const ActionSet none;
+    return id < requirements.size() ? requirements[id] : none;
+}
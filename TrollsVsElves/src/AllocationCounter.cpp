@@ -0,0 +1,109 @@
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// each thread counts in its own slot, padded so job workers allocating at once don't fight over a cache line
+struct alignas(64) AllocationSlot
+{
+    std::atomic<uint64_t> count = 0;
+};
+
+static constexpr unsigned NR_OF_SLOTS = 64;
+static AllocationSlot slots[NR_OF_SLOTS];
+static std::atomic<unsigned> nextSlot = 0;
+static thread_local unsigned threadSlot = NR_OF_SLOTS; // picked on the thread's first allocation
+
+static void countAllocation()
+{
+    if (threadSlot == NR_OF_SLOTS)
+        threadSlot = nextSlot.fetch_add(1, std::memory_order_relaxed) % NR_OF_SLOTS;
+    slots[threadSlot].count.fetch_add(1, std::memory_order_relaxed);
+}
+
+static uint64_t countHeapAllocations()
+{
+    uint64_t total = 0;
+    for (const AllocationSlot& slot: slots)
+        total += slot.count.load(std::memory_order_relaxed);
+    return total;
+}
+
+static const bool hooked = (heapAllocationCounter = countHeapAllocations, true);
+
+static void* alignedMalloc(size_t size, size_t alignment)
+{
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1)); // size must be a multiple of it
+#endif
+}
+
+static void alignedFree(void* pointer)
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void* operator new(size_t size)
+{
+    countAllocation();
+    while (true)
+    {
+        if (void* pointer = std::malloc(size ? size : 1))
+            return pointer;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    // std::pmr::new_delete_resource always asks for an alignment
+    countAllocation();
+    size_t align = std::max(size_t(alignment), sizeof(void*));
+    while (true)
+    {
+        if (void* pointer = alignedMalloc(std::max<size_t>(size, 1), align))
+            return pointer;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return operator new(size); }
+    catch (...) { return nullptr; }
+}
+
+void* operator new[](size_t size)                                   { return operator new(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept   { return operator new(size, std::nothrow); }
+void* operator new[](size_t size, std::align_val_t alignment)       { return operator new(size, alignment); }
+
+void operator delete(void* pointer) noexcept                              { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept                      { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept       { std::free(pointer); }
+void operator delete[](void* pointer) noexcept                            { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept                    { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept     { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept            { alignedFree(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept    { alignedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept          { alignedFree(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept  { alignedFree(pointer); }
@@ -1,37 +1,53 @@
 #include "BuildingManager.h"
 #include "Player.h"
+#include "JobSystem.h"
 
-BuildingManager::BuildingManager(Vector3 defaultBuildingSize, Color defaultBuildingColor, MapGenerator* mapGenerator)
+BuildingManager::BuildingManager(Vector3 defaultBuildingSize, Color defaultBuildingColor, MapGenerator* mapGenerator, CameraManager* cameraManager)
 {
     this->defaultBuildingSize = defaultBuildingSize;
     this->defaultBuildingColor = defaultBuildingColor;
     this->mapGenerator = mapGenerator;
+    this->cameraManager = cameraManager;
 
     buildings.reserve(100);
 
     ghost.reset();
-    selectedIndex = -1;
 
     // make sure zeroth level buildings are always available to build
-    unlockedActions["castle0"] = 1;
-    unlockedActions["rock0"] = 1;
-    unlockedActions["hall0"] = 1;
+    unlockCounts.fill(0);
+    unlockedActionsVersion = 0;
+    ActionsManager& actionsManager = ActionsManager::get();
+    unlock(actionsManager.getId("castle0"));
+    unlock(actionsManager.getId("rock0"));
+    unlock(actionsManager.getId("hall0"));
 }
 
 BuildingManager::~BuildingManager() {}
 
-void BuildingManager::draw()
+DrawCounts BuildingManager::draw(const Frustum& frustum, InstancedRenderer& renderer)
 {
-    for (size_t i = 0; i < buildings.size(); i++)
+    DrawCounts counts;
+    // the rally point is away from the building, always drawn
+    Building* selectedBuilding = getSelectedBuilding();
+    if (selectedBuilding && !Vector3Equals(selectedBuilding->rallyPoint.position, selectedBuilding->cube.position))
+        drawCylinder(selectedBuilding->rallyPoint);
+
+    for (Building& building: buildings)
     {
-        drawCube(buildings[i].cube);
-        if (i == selectedIndex && !Vector3Equals(buildings[i].rallyPoint.position, buildings[i].cube.position))
-            drawCylinder(buildings[i].rallyPoint);
+        if (!mapGenerator->isVisible(frustum, getCubeBoundingBox(building.cube)))
+        {
+            counts.culled++;
+            continue;
+        }
+        renderer.addCube(building.cube);
+        counts.submitted++;
     }
 
-    for (Building& building: buildQueue)
-        drawCube(building.cube);
+    return counts;
+}
 
+void BuildingManager::drawGhost()
+{
     if (ghost.exists())
     {
         Building& ghostBuilding = ghost.get();
@@ -42,63 +58,99 @@ void BuildingManager::draw()
     }
 }
 
-Building* BuildingManager::raycastToBuilding()
+BuildingHandle BuildingManager::raycastToBuilding()
 {
-    Ray ray = CameraManager::get().getMouseRay();
+    Ray ray = cameraManager->getMouseRay();
     float closestCollisionDistance = std::numeric_limits<float>::infinity();
-    Building* nearestBuilding = nullptr;
+    BuildingHandle nearestBuilding;
 
-    for (Building& building: buildings)
+    for (size_t i = 0; i < buildings.size(); i++)
     {
+        Building& building = buildings.at(i);
+        if (building.buildStage == SCHEDULED) // not there yet
+            continue;
+
         RayCollision collision = GetRayCollisionBox(ray, getCubeBoundingBox(building.cube));
 
         if (collision.hit && collision.distance < closestCollisionDistance)
         {
             closestCollisionDistance = collision.distance;
-            nearestBuilding = &building;
+            nearestBuilding = buildings.getHandle(i);
         }
     }
 
     return nearestBuilding;
 }
 
-void BuildingManager::removeBuilding(size_t index)
+BuildingHandle BuildingManager::addBuilding(Building building)
 {
-    assert(index < buildings.size());
+    Player* owner = building.owner;
+    BuildingHandle handle = buildings.insert(building);
+    if (owner)
+        owner->buildings.push_back(handle);
 
-    Building& building = buildings[index];
+    return handle;
+}
 
-    for (std::string& id: building.previousActionIds)
-        unlockedActions[id]--;
-    unlockedActions[building.actionId]--;
+void BuildingManager::removeBuilding(BuildingHandle handle)
+{
+    Building* building = buildings.get(handle);
+    assert(building); // SANITY
+
+    for (ActionId id: building->previousActionIds)
+        lock(id);
+    lock(building->actionId);
+
+    if (Player* owner = building->owner)
+        owner->buildings.erase(std::find(owner->buildings.begin(), owner->buildings.end(), handle));
+
+    if (building->buildStage == IN_PROGRESS)
+    {
+        auto progress = std::find_if(inProgress.begin(), inProgress.end(), [&](const BuildProgress& progress) { return progress.handle == handle; });
+        *progress = inProgress.back();
+        inProgress.pop_back();
+    }
+
+    if (handle == selected)
+        selected = BuildingHandle();
 
-    std::swap(buildings[index], buildings[buildings.size() - 1]);
-    buildings.pop_back();
+    buildings.remove(handle);
+}
+
+Building* BuildingManager::getSelectedBuilding()
+{
+    return buildings.get(selected);
 }
 
 void BuildingManager::update()
 {
-    float dt = GetFrameTime();
-    for (size_t i = 0; i < buildings.size(); i++)
+    float dt = InputManager::get().getFrameTime();
+    JobSystem::get().parallelFor(inProgress.size(), constants::JOB_BUILDINGS_PER_JOB, [this, dt](size_t begin, size_t end) {
+        advanceBuilds(begin, end, dt);
+    });
+
+    for (size_t i = 0; i < inProgress.size(); i++)
     {
-        Building& building = buildings[i];
-        if (building.buildStage == BuildStage::IN_PROGRESS)
-        {
-            building.buildTimer += dt;
-            float adjusted = building.buildTimer / building.buildTime;
-            building.cube.color = lerpColor(building.inProgressColor, building.targetColor, adjusted);
+        BuildProgress& progress = inProgress[i];
+        Building& building = *buildings.get(progress.handle);
+        building.cube.color = progress.color;
 
-            if (building.buildTimer >= building.buildTime)
-                progressBuilding(building, FINISHED);
+        if (progress.timer >= progress.time)
+        {
+            progressBuilding(building, FINISHED);
+            inProgress[i] = inProgress.back();
+            inProgress.pop_back();
+            i--;
         }
+    }
 
+    for (size_t i = 0; i < buildings.size(); i++)
+    {
+        Building& building = buildings.at(i);
         if (building.sold)
         {
-            if (i == selectedIndex)
-                selectedIndex = -1;
-
             mapGenerator->removeObstacle(building.cube);
-            removeBuilding(i);
+            removeBuilding(buildings.getHandle(i)); // the last building is moved to i
             i--;
         }
     }
@@ -107,34 +159,53 @@ void BuildingManager::update()
         updateGhostBuilding();
 }
 
-Building* BuildingManager::yieldBuildQueue()
+void BuildingManager::advanceBuilds(size_t begin, size_t end, float dt)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        BuildProgress& progress = inProgress[i];
+        progress.timer += dt;
+        progress.color = lerpColor(progress.from, progress.to, progress.timer / progress.time);
+    }
+}
+
+Building* BuildingManager::yieldBuildQueue(Player* player)
 {
-    assert(buildQueue.size() != 0);
+    Building* building = buildQueueFront(player);
+    assert(building);
 
-    Building& building = buildQueue.front();
-    buildQueue.pop_front();
-    progressBuilding(building, IN_PROGRESS);
-    buildings.push_back(building);
+    BuildingHandle handle = player->buildQueue.front();
+    player->buildQueue.pop_front();
+    progressBuilding(*building, IN_PROGRESS);
+    inProgress.push_back({ handle, 0.f, building->buildTime, building->inProgressColor, building->targetColor, building->cube.color });
 
-    return &buildings.back();
+    return building;
 }
 
-Building* BuildingManager::buildQueueFront()
+Building* BuildingManager::buildQueueFront(Player* player)
 {
-    return buildQueue.size() ? &buildQueue.front() : nullptr;
+    std::deque<BuildingHandle>& buildQueue = player->buildQueue;
+    while (buildQueue.size() && !buildings.contains(buildQueue.front())) // removed while waiting
+        buildQueue.pop_front();
+
+    return buildQueue.size() ? buildings.get(buildQueue.front()) : nullptr;
 }
 
-void BuildingManager::clearBuildQueue()
+void BuildingManager::clearBuildQueue(Player* player)
 {
-    while(buildQueue.size())
-        buildQueue.pop_back();
+    for (BuildingHandle handle: player->buildQueue)
+        if (buildings.contains(handle))
+            removeBuilding(handle);
+
+    player->buildQueue.clear();
 }
 
 void BuildingManager::updateGhostBuilding()
 {
     assert(ghost.exists());
 
-    Cube* cubeHit = mapGenerator->raycastToGround();
+    Ray ray = cameraManager->getMouseRay();
+    std::optional<Cube> cubeHit = mapGenerator->raycastToGround(ray);
     if (!cubeHit)
         return;
 
@@ -143,7 +214,7 @@ void BuildingManager::updateGhostBuilding()
     const float max = 10000.f;
     // Check mouse collision against a plane spanning from -max to max, with y the same as the cubeHit y-level
     RayCollision collision = GetRayCollisionQuad(
-        CameraManager::get().getMouseRay(),
+        ray,
         { -max, ground + (cubeHit->position.y + cubeSize.y/2), -max },
         { -max, ground + (cubeHit->position.y + cubeSize.y/2),  max },
         {  max, ground + (cubeHit->position.y + cubeSize.y/2),  max },
@@ -173,7 +244,7 @@ void BuildingManager::updateGhostBuilding()
 
     Building& ghostBuilding = ghost.get();
     ghostBuilding.cube.position = final;
-    ghost.isColliding = (isColliding(buildings, &ghostBuilding) || isColliding(buildQueue, &ghostBuilding));
+    ghost.isColliding = isColliding(buildings, &ghostBuilding);
     ghostBuilding.cube.color = ghost.isColliding ? RED : ghostBuilding.ghostColor;
 }
 
@@ -192,8 +263,34 @@ bool BuildingManager::isColliding(const Container& buildings, Building* targetBu
 void BuildingManager::createDebugBuilding(Vector2i index, BuildingType buildingType)
 {
     Building building = Building(Cube(defaultBuildingSize), buildingType, nullptr);
-    unlockedActions[building.actionId]++;
+    unlock(building.actionId);
+
+    building.cube.position = indexToBuildingPosition(index);
+    mapGenerator->addObstacle(building.cube);
 
+    progressBuilding(building, FINISHED);
+    addBuilding(building);
+}
+
+void BuildingManager::createNewGhostBuilding(BuildingType buildingType, Player* player)
+{
+    ghost.set(Building(Cube(defaultBuildingSize), buildingType, player));
+    updateGhostBuilding(); // sets position, and color correctly
+}
+
+void BuildingManager::placeGhostBuilding(Vector2i index)
+{
+    // same as updateGhostBuilding but positioned from a grid index instead of the mouse
+    assert(ghost.exists());
+
+    Building& ghostBuilding = ghost.get();
+    ghostBuilding.cube.position = indexToBuildingPosition(index);
+    ghost.isColliding = isColliding(buildings, &ghostBuilding);
+    ghostBuilding.cube.color = ghost.isColliding ? RED : ghostBuilding.ghostColor;
+}
+
+Vector3 BuildingManager::indexToBuildingPosition(Vector2i index)
+{
     Vector3 pos = mapGenerator->indexToWorldPosition(index);
     Vector3 cubeSize = mapGenerator->cubeSize;
     Vector3 snapped = {
@@ -207,17 +304,7 @@ void BuildingManager::createDebugBuilding(Vector2i index, BuildingType buildingT
         (cubeSize.z - defaultBuildingSize.z) / 2.0f,
     };
 
-    building.cube.position = Vector3Add(snapped, offset);
-    mapGenerator->addObstacle(building.cube);
-
-    progressBuilding(building, FINISHED);
-    buildings.push_back(building);
-}
-
-void BuildingManager::createNewGhostBuilding(BuildingType buildingType, Player* player)
-{
-    ghost.set(Building(Cube(defaultBuildingSize), buildingType, player));
-    updateGhostBuilding(); // sets position, and color correctly
+    return Vector3Add(snapped, offset);
 }
 
 void BuildingManager::scheduleGhostBuilding()
@@ -225,9 +312,11 @@ void BuildingManager::scheduleGhostBuilding()
     assert(ghost.exists());
 
     Building& ghostBuilding = ghost.get();
-    unlockedActions[ghostBuilding.actionId]++;
+    assert(ghostBuilding.owner); // someone has to build it
+
+    unlock(ghostBuilding.actionId);
     progressBuilding(ghostBuilding, SCHEDULED);
-    buildQueue.push_back(ghostBuilding);
+    ghostBuilding.owner->buildQueue.push_back(addBuilding(ghostBuilding));
 
     ghost.reset();
 }
@@ -248,47 +337,41 @@ void BuildingManager::progressBuilding(Building& building, BuildStage stage)
         case IN_PROGRESS: break;
         case FINISHED:
             building.cube.color = building.selected ? building.selectedColor : building.targetColor;
-            building.buildTimer = 0.f;
             break;
     }
 
     building.buildStage = stage;
 }
 
-void BuildingManager::select(Building* building)
+void BuildingManager::select(BuildingHandle handle)
 {
-    selectedIndex = -1;
-    Cube& cube = building->cube;
-    for (size_t i = 0; i < buildings.size() && selectedIndex == -1; i++)
-        if (cube == buildings[i].cube)
-            selectedIndex = i;
-
-    assert(selectedIndex != -1); // SANITY
-
-    Building& selectedBuilding = buildings[selectedIndex];
-    selectedBuilding.selected = true;
-    if (selectedBuilding.buildStage != IN_PROGRESS)
-        selectedBuilding.cube.color = selectedBuilding.selectedColor;
+    Building* building = buildings.get(handle);
+    assert(building); // SANITY
+
+    selected = handle;
+    building->selected = true;
+    if (building->buildStage != IN_PROGRESS)
+        building->cube.color = building->selectedColor;
 }
 
 void BuildingManager::deselect()
 {
-    if (selectedIndex == -1)
+    Building* building = getSelectedBuilding();
+    selected = BuildingHandle();
+    if (!building)
         return;
 
-    Building& building = buildings[selectedIndex];
-    building.selected = false;
-    if (building.buildStage != IN_PROGRESS)
-        building.cube.color = building.targetColor;
-    selectedIndex = -1;
+    building->selected = false;
+    if (building->buildStage != IN_PROGRESS)
+        building->cube.color = building->targetColor;
 }
 
 void BuildingManager::recruit(Building* building)
 {
-    std::vector<Vector2i> neighboringIndices = mapGenerator->getNeighboringIndices(building->cube);
+    std::pmr::vector<Vector2i> neighboringIndices = mapGenerator->getNeighboringIndices(building->cube);
     if (!neighboringIndices.size()) // no valid neighboring tiles
     {
-        printf("Found no neighboring tiles, should probably do something about this later\n"); // TODO: later
+        LOG_WARNING("Found no neighboring tiles, should probably do something about this later"); // TODO: later
         return;
     }
 
@@ -305,31 +388,55 @@ void BuildingManager::recruit(Building* building)
     // entities.push_back(entity);
 }
 
-bool BuildingManager::canPromoteTo(std::string id)
+void BuildingManager::unlock(ActionId id)
+{
+    if (id >= MAX_ACTIONS)
+        return;
+
+    if (unlockCounts[id]++ == 0)
+    {
+        unlockedActions.set(id);
+        unlockedActionsVersion++;
+    }
+}
+
+void BuildingManager::lock(ActionId id)
 {
-    std::vector<std::string> requirements = ActionsManager::get().requirements[id];
-    for (const std::string& id: requirements)
-        if (unlockedActions[id] == 0) // defaults to 0 if it doesn't exist
-            return false;
+    if (id >= MAX_ACTIONS || unlockCounts[id] == 0)
+        return;
+
+    if (--unlockCounts[id] == 0)
+    {
+        unlockedActions.reset(id);
+        unlockedActionsVersion++;
+    }
+}
 
-    return true;
+bool BuildingManager::canPromoteTo(ActionId id)
+{
+    // every requirement has to be unlocked, i.e. the requirements are a subset of the unlocked actions
+    return (ActionsManager::get().getRequirements(id) & ~unlockedActions).none();
 }
 
-void BuildingManager::promote(Building& building, std::string id)
+void BuildingManager::promote(Building& building, ActionId id)
 {
-    printf("promote %s to %s\n", building.actionId.c_str(), id.c_str());
+    LOG_DEBUG("promote %s to %s", ActionsManager::get().getKey(building.actionId).c_str(), ActionsManager::get().getKey(id).c_str());
 
-    unlockedActions[id]++;
+    unlock(id);
     building.previousActionIds.push_back(building.actionId);
     building.actionId = id;
 }
 
-std::vector<ActionNode> BuildingManager::getActions(Building& building, int nrOfButtons)
+std::vector<ActionNode> BuildingManager::getActions(BuildingHandle handle, int nrOfButtons)
 {
-    std::vector<ActionNode> children = ActionsManager::get().getActionChildren(building.actionId);
+    Building* building = buildings.get(handle);
+    assert(building); // SANITY
+
+    ActionsManager& actionsManager = ActionsManager::get();
+    std::vector<ActionNode> children = actionsManager.getActionChildren(building->actionId);
 
-    ActionNode fillerButton = ActionNode("filler", "Filler", "filler", {});
-    ActionNode sellButton = ActionNode("sell", "Sell", "sell", {});
+    const ActionNode& fillerButton = actionsManager.getNode(FILLER_ACTION);
+    const ActionNode& sellButton = actionsManager.getNode(SELL_ACTION);
 
     int nrOfFillerButtons = nrOfButtons - children.size();
     for (int i = 0; i < nrOfFillerButtons - 1; i++)
@@ -340,18 +447,40 @@ std::vector<ActionNode> BuildingManager::getActions(Building& building, int nrOf
     for (ActionNode& node: children)
     {
         node.promotable = canPromoteTo(node.id);
-        if (node.id == "filler")
-            node.callback = []() {};
-        else if (node.action == "sell")
-            node.callback = [&building]() { building.sold = true; };
-        else if (node.action == "recruit")
-            node.callback = []() { printf("'recruit' action is not implemented\n"); };
-        else if (node.action == "buy")
-            node.callback = []() { printf("'buy' action is not implemented\n"); };
-        else if (node.action == "promote")
+        ActionId id = node.id;
+        switch (node.type)
         {
-            if (node.promotable)    node.callback = [this, &building, node]() { this->promote(building, node.id); };
-            else                    node.callback = []() {};
+            case ACTION_FILLER:
+                node.callback = []() {};
+                break;
+
+            case ACTION_SELL:
+                node.callback = [this, handle]() {
+                    if (Building* building = this->buildings.get(handle))
+                        building->sold = true;
+                };
+                break;
+
+            case ACTION_RECRUIT:
+                node.callback = []() { LOG_WARNING("'recruit' action is not implemented"); };
+                break;
+
+            case ACTION_BUY:
+                node.callback = []() { LOG_WARNING("'buy' action is not implemented"); };
+                break;
+
+            case ACTION_PROMOTE:
+                if (node.promotable)
+                    node.callback = [this, handle, id]() {
+                        if (Building* building = this->buildings.get(handle))
+                            this->promote(*building, id);
+                    };
+                else
+                    node.callback = []() {};
+                break;
+
+            default:
+                break;
         }
     }
 
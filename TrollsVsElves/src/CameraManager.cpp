@@ -1,4 +1,5 @@
 #include "CameraManager.h"
+#include "rlgl.h"
 
 CameraManager::CameraManager()
 {
@@ -18,25 +19,29 @@ CameraManager::CameraManager()
         .rotation = 0.f,
         .zoom = 1.f
     };
+
+    viewProjection = MatrixIdentity();
+    screenSize = { 0.f, 0.f };
 }
 
 void CameraManager::update()
 {
-    float dt = GetFrameTime();
+    InputManager& inputManager = InputManager::get();
+    float dt = inputManager.getFrameTime();
     // Camera panning
     float cameraPan = 150.0f * dt;
 
-    if (IsKeyDown(KEY_A))      CameraMoveRight(&camera, -cameraPan, true);
-    else if (IsKeyDown(KEY_D)) CameraMoveRight(&camera, cameraPan, true);
+    if (inputManager.isKeyDown(KEY_A))      CameraMoveRight(&camera, -cameraPan, true);
+    else if (inputManager.isKeyDown(KEY_D)) CameraMoveRight(&camera, cameraPan, true);
 
-    if (IsKeyDown(KEY_W))      CameraMoveForward(&camera, cameraPan, true);
-    else if (IsKeyDown(KEY_S)) CameraMoveForward(&camera, -cameraPan, true);
+    if (inputManager.isKeyDown(KEY_W))      CameraMoveForward(&camera, cameraPan, true);
+    else if (inputManager.isKeyDown(KEY_S)) CameraMoveForward(&camera, -cameraPan, true);
 
     // Camera zooming
     float maxDistance = 120.f;
     float minDistance = 10.f;
     float scrollAmount = 100.f * dt;
-    float scroll = -GetMouseWheelMove(); // inverted for a reason
+    float scroll = -inputManager.getMouseWheelMove(); // inverted for a reason
     if (scroll)
     {
         bool scrollUp = scroll == 1;
@@ -49,6 +54,19 @@ void CameraManager::update()
 
         CameraMoveToTarget(&camera, scroll);
     }
+
+    updateProjection();
+}
+
+void CameraManager::updateProjection()
+{
+    screenSize = { float(GetScreenWidth()), float(GetScreenHeight()) };
+    if (screenSize.y == 0.f) // no window
+        return;
+
+    // the same projection BeginMode3D sets up
+    Matrix projection = MatrixPerspective(camera.fovy * DEG2RAD, screenSize.x / screenSize.y, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    viewProjection = MatrixMultiply(GetCameraMatrix(camera), projection);
 }
 
 Camera3D& CameraManager::getCamera()
@@ -68,12 +86,23 @@ Matrix CameraManager::getCameraViewMatrix()
 
 Ray CameraManager::getMouseRay()
 {
-    return GetMouseRay(GetMousePosition(), camera);
+    return GetMouseRay(InputManager::get().getMousePosition(), camera);
+}
+
+Frustum CameraManager::getFrustum()
+{
+    return Frustum(viewProjection);
 }
 
 Vector2 CameraManager::getWorldToScreen(Vector3 position)
 {
-    return GetWorldToScreen(position, camera);
+    const Matrix& m = viewProjection;
+    float x = m.m0 * position.x + m.m4 * position.y + m.m8 * position.z + m.m12;
+    float y = m.m1 * position.x + m.m5 * position.y + m.m9 * position.z + m.m13;
+    float w = m.m3 * position.x + m.m7 * position.y + m.m11 * position.z + m.m15;
+
+    // normalized device coordinates to pixels, y points down on screen
+    return { (x / w + 1.f) / 2.f * screenSize.x, (-y / w + 1.f) / 2.f * screenSize.y };
 }
 
 float CameraManager::calculateCircleRadius2D(Vector3 position, float radius)
@@ -0,0 +1,338 @@
+#include "ConnectedComponents.h"
+
+#include <algorithm>
+
+static const Vector2i directions[8] = { { -1, 0}, { 1, 0}, { 0, -1}, { 0, 1}, { -1, -1}, { 1, 1}, { -1, 1}, { 1, -1} };
+
+ConnectedComponents::ConnectedComponents()
+{
+    size = { 0, 0 };
+    visitStamp = 0;
+}
+
+ConnectedComponents::~ConnectedComponents() {}
+
+void ConnectedComponents::rebuild(const std::vector<std::vector<bool>>& obstacles)
+{
+    this->obstacles = obstacles;
+    size = { obstacles.empty() ? 0 : int(obstacles[0].size()), int(obstacles.size()) };
+    labels = std::vector<int>(size.x * size.y, BLOCKED);
+    componentSizes.clear();
+    freeLabels.clear();
+    visitStamps = std::vector<uint32_t>(size.x * size.y, 0);
+    visitOwners = std::vector<size_t>(size.x * size.y, 0);
+    visitStamp = 0;
+
+    const int unlabeled = -2;
+    for (int y = 0; y < size.y; y++)
+        for (int x = 0; x < size.x; x++)
+            if (!obstacles[y][x])
+                labels[y * size.x + x] = unlabeled;
+
+    for (int y = 0; y < size.y; y++)
+        for (int x = 0; x < size.x; x++)
+            if (labels[y * size.x + x] == unlabeled)
+                flood({ x, y }, newLabel(), unlabeled);
+}
+
+void ConnectedComponents::update(const std::vector<std::vector<bool>>& obstacles)
+{
+    if (obstacles.size() != size_t(size.y) || (size.y && obstacles[0].size() != size_t(size.x)))
+    {
+        rebuild(obstacles);
+        return;
+    }
+
+    // rows are compared whole first, which is a word-wise compare for std::vector<bool>
+    std::vector<Vector2i> blocked;
+    std::vector<Vector2i> unblocked;
+    for (int y = 0; y < size.y; y++)
+    {
+        if (obstacles[y] == this->obstacles[y])
+            continue;
+
+        for (int x = 0; x < size.x; x++)
+        {
+            if (obstacles[y][x] == this->obstacles[y][x])
+                continue;
+
+            if (obstacles[y][x])    blocked.push_back({ x, y });
+            else                    unblocked.push_back({ x, y });
+        }
+
+        this->obstacles[y] = obstacles[y];
+    }
+
+    if (blocked.size())
+        block(blocked);
+    if (unblocked.size())
+        unblock(unblocked);
+}
+
+int ConnectedComponents::getLabel(Vector2i index)
+{
+    return inBounds(index) ? labels[index.y * size.x + index.x] : BLOCKED;
+}
+
+bool ConnectedComponents::isReachable(Vector2i from, Vector2i to)
+{
+    int label = getLabel(from);
+    return label != BLOCKED && label == getLabel(to);
+}
+
+Vector2i ConnectedComponents::findNearestReachable(Vector2i from, Vector2i to)
+{
+    int label = getLabel(from);
+    if (label == BLOCKED || label == getLabel(to)) // nothing to redirect, let the pathfinding decide
+        return to;
+
+    // walk square rings around the goal, closest cell of the first ring that touches the start's region wins
+    int maxRadius = std::max(size.x, size.y);
+    for (int radius = 1; radius <= maxRadius; radius++)
+    {
+        Vector2i nearest = from;
+        int nearestDistance = -1;
+        for (int y = to.y - radius; y <= to.y + radius; y++)
+        {
+            bool isEdgeRow = (y == to.y - radius || y == to.y + radius);
+            int step = isEdgeRow ? 1 : radius * 2;
+            for (int x = to.x - radius; x <= to.x + radius; x += step)
+            {
+                if (getLabel({ x, y }) != label)
+                    continue;
+
+                int distance = (x - to.x) * (x - to.x) + (y - to.y) * (y - to.y);
+                if (nearestDistance == -1 || distance < nearestDistance)
+                {
+                    nearest = { x, y };
+                    nearestDistance = distance;
+                }
+            }
+        }
+
+        if (nearestDistance != -1)
+            return nearest;
+    }
+
+    return from;
+}
+
+bool ConnectedComponents::inBounds(Vector2i index)
+{
+    return index.x >= 0 && index.x < size.x && index.y >= 0 && index.y < size.y;
+}
+
+int ConnectedComponents::newLabel()
+{
+    while (freeLabels.size()) // reuse labels of components that were merged or removed
+    {
+        int label = freeLabels.back();
+        freeLabels.pop_back();
+        if (componentSizes[label] == 0)
+            return label;
+    }
+
+    componentSizes.push_back(0);
+    return componentSizes.size() - 1;
+}
+
+void ConnectedComponents::addToComponent(int label, int count)
+{
+    componentSizes[label] += count;
+    if (count < 0 && componentSizes[label] == 0)
+        freeLabels.push_back(label);
+}
+
+void ConnectedComponents::flood(Vector2i from, int label, int expectedLabel)
+{
+    // relabels every cell carrying expectedLabel that is 8-connected to from, from itself must carry expectedLabel
+    std::vector<Vector2i> stack = { from };
+    labels[from.y * size.x + from.x] = label;
+    addToComponent(label, 1);
+    if (expectedLabel >= 0)
+        addToComponent(expectedLabel, -1);
+
+    Vector2i pos;
+    while (stack.size())
+    {
+        Vector2i current = stack.back();
+        stack.pop_back();
+
+        for (Vector2i direction: directions)
+        {
+            pos = { current.x + direction.x, current.y + direction.y };
+            if (!inBounds(pos) || labels[pos.y * size.x + pos.x] != expectedLabel)
+                continue;
+
+            labels[pos.y * size.x + pos.x] = label;
+            addToComponent(label, 1);
+            if (expectedLabel >= 0)
+                addToComponent(expectedLabel, -1);
+            stack.push_back(pos);
+        }
+    }
+}
+
+void ConnectedComponents::block(std::vector<Vector2i>& cells)
+{
+    for (Vector2i cell: cells)
+    {
+        int& label = labels[cell.y * size.x + cell.x];
+        addToComponent(label, -1);
+        label = BLOCKED;
+    }
+
+    // a region can only have been split where cells were blocked and every piece touches one of them,
+    // their open neighbors are the seeds, grouped by the region they are in
+    std::vector<std::pair<int, Vector2i>> seeds;
+    Vector2i pos;
+    for (Vector2i cell: cells)
+    {
+        for (Vector2i direction: directions)
+        {
+            pos = { cell.x + direction.x, cell.y + direction.y };
+            int label = getLabel(pos);
+            if (label != BLOCKED)
+                seeds.push_back({ label, pos });
+        }
+    }
+
+    auto order = [](const std::pair<int, Vector2i>& lhs, const std::pair<int, Vector2i>& rhs) {
+        if (lhs.first != rhs.first) return lhs.first < rhs.first;
+        return lhs.second.y != rhs.second.y ? lhs.second.y < rhs.second.y : lhs.second.x < rhs.second.x;
+    };
+    std::sort(seeds.begin(), seeds.end(), order);
+    seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
+
+    std::vector<Vector2i> regionSeeds;
+    for (size_t begin = 0, end; begin < seeds.size(); begin = end)
+    {
+        regionSeeds.clear();
+        for (end = begin; end < seeds.size() && seeds[end].first == seeds[begin].first; end++)
+            regionSeeds.push_back(seeds[end].second);
+
+        if (regionSeeds.size() > 1) // a single piece touching the blocked cells is the whole region
+            separatePieces(seeds[begin].first, regionSeeds);
+    }
+}
+
+void ConnectedComponents::separatePieces(int label, const std::vector<Vector2i>& seeds)
+{
+    // searches from every seed at once, one cell per search in turn, searches that touch are in the same piece
+    // and merge. A search that runs out of cells before it met the others found a piece of its own, which gets
+    // a new label. Done once one search is left, so an unsplit region only costs a walk around the blocked cells
+    // and of a split one only the pieces that finish first, the smaller ones, are relabeled
+    visitStamp++;
+    std::vector<PieceSearch> searches(seeds.size());
+    for (size_t i = 0; i < seeds.size(); i++)
+    {
+        int index = seeds[i].y * size.x + seeds[i].x;
+        visitStamps[index] = visitStamp;
+        visitOwners[index] = i;
+        searches[i].frontier.push_back(seeds[i]);
+        searches[i].cells.push_back(seeds[i]);
+        searches[i].parent = i;
+    }
+
+    auto find = [&searches](size_t i) {
+        while (searches[i].parent != i)
+            i = searches[i].parent = searches[searches[i].parent].parent;
+        return i;
+    };
+
+    std::vector<size_t> active(searches.size()); // searches that neither finished nor were merged, as of this round
+    for (size_t i = 0; i < active.size(); i++)
+        active[i] = i;
+
+    size_t remaining = searches.size();
+    Vector2i pos;
+    while (remaining > 1)
+    {
+        active.erase(std::remove_if(active.begin(), active.end(), [&searches](size_t i) {
+            return searches[i].finished || searches[i].parent != i;
+        }), active.end());
+
+        for (size_t k = 0; k < active.size() && remaining > 1; k++)
+        {
+            size_t i = active[k];
+            PieceSearch& search = searches[i];
+            if (search.parent != i) // merged earlier this round
+                continue;
+
+            if (search.head == search.frontier.size())
+            {
+                int pieceLabel = newLabel();
+                for (Vector2i cell: search.cells)
+                    labels[cell.y * size.x + cell.x] = pieceLabel;
+                addToComponent(pieceLabel, int(search.cells.size()));
+                addToComponent(label, -int(search.cells.size()));
+
+                search.finished = true;
+                remaining--;
+                continue;
+            }
+
+            Vector2i current = search.frontier[search.head++];
+            for (Vector2i direction: directions)
+            {
+                pos = { current.x + direction.x, current.y + direction.y };
+                int index = pos.y * size.x + pos.x;
+                if (!inBounds(pos) || labels[index] != label)
+                    continue;
+
+                if (visitStamps[index] != visitStamp)
+                {
+                    visitStamps[index] = visitStamp;
+                    visitOwners[index] = i;
+                    search.frontier.push_back(pos);
+                    search.cells.push_back(pos);
+                    continue;
+                }
+
+                size_t other = find(visitOwners[index]);
+                if (other == i)
+                    continue;
+
+                // same piece, this search goes on as both, appending the smaller arrays to the bigger ones
+                PieceSearch& merged = searches[other];
+                if (merged.cells.size() > search.cells.size())
+                {
+                    std::swap(search.frontier, merged.frontier);
+                    std::swap(search.head, merged.head);
+                    std::swap(search.cells, merged.cells);
+                }
+                search.frontier.insert(search.frontier.end(), merged.frontier.begin() + merged.head, merged.frontier.end());
+                search.cells.insert(search.cells.end(), merged.cells.begin(), merged.cells.end());
+                merged = PieceSearch();
+                merged.parent = i;
+                remaining--;
+            }
+        }
+    }
+}
+
+void ConnectedComponents::unblock(std::vector<Vector2i>& cells)
+{
+    Vector2i pos;
+    for (Vector2i cell: cells)
+    {
+        int label = newLabel();
+        labels[cell.y * size.x + cell.x] = label;
+        addToComponent(label, 1);
+
+        // merge neighboring regions by relabeling the smaller one of each pair
+        for (Vector2i direction: directions)
+        {
+            pos = { cell.x + direction.x, cell.y + direction.y };
+            int cellLabel = labels[cell.y * size.x + cell.x];
+            int neighborLabel = getLabel(pos);
+            if (neighborLabel == BLOCKED || neighborLabel == cellLabel)
+                continue;
+
+            if (componentSizes[neighborLabel] >= componentSizes[cellLabel])
+                flood(cell, neighborLabel, cellLabel);
+            else
+                flood(pos, cellLabel, neighborLabel);
+        }
+    }
+}
@@ -20,9 +20,9 @@ Entity::Entity(Vector3 position, Color defaultColor, EntityType entityType)
 
 Entity::~Entity() {}
 
-void Entity::draw()
+void Entity::draw(InstancedRenderer& renderer)
 {
-    drawCapsule(capsule);
+    renderer.addCapsule(capsule);
 
     if (state == RUNNING)
         drawCylinder(targetMarker);
@@ -40,7 +40,7 @@ void Entity::updateMovement()
     Vector3 direction = Vector3Subtract(target, capsule.startPos);
     Vector3 directionNormalized = Vector3Normalize(direction);
 
-    Vector3 velocity = Vector3Scale(Vector3Multiply(directionNormalized, speed), GetFrameTime());
+    Vector3 velocity = Vector3Scale(Vector3Multiply(directionNormalized, speed), InputManager::get().getFrameTime());
 
     capsule.startPos = Vector3Add(capsule.startPos, velocity);
     capsule.endPos = Vector3Add(capsule.endPos, velocity);
@@ -51,7 +51,7 @@ void Entity::updateMovement()
         capsule.startPos = { target.x, capsule.startPos.y, target.z };  // just tp to it
         capsule.endPos = { target.x, capsule.endPos.y, target.z };      // just tp to it
 
-        path.pop_front(); // reached the end of this path
+        path.popFront(); // reached the end of this path
         if (path.empty())
         {
             setState(IDLE);
@@ -65,10 +65,9 @@ Vector3 Entity::getPosition()
     return capsule.startPos;
 }
 
-void Entity::setPath(std::vector<Vector3> newPath)
+void Entity::setPath(Path newPath)
 {
-    path.clear();
-    path.insert(path.end(), newPath.begin(), newPath.end());
+    path = std::move(newPath);
 
     // TODO, WARNING
     // When no path was found from the pathfinding this handling is incorrect,
@@ -85,10 +84,10 @@ void Entity::setPath(std::vector<Vector3> newPath)
     }
 }
 
-void Entity::correctPath(std::vector<Vector3> path)
+void Entity::correctPath(Path path)
 {
     // TODO: do some actual correction logic here
-    setPath(path);
+    setPath(std::move(path));
 }
 
 void Entity::setDefaultColor(Color color)
@@ -131,7 +130,7 @@ void Entity::setState(State newState)
             case IDLE:      previousStateString = "IDLE";       break;
             case RUNNING:   previousStateString = "RUNNING";    break;
         }
-        printf("newState, previousState: %s, %s\n", stateString.c_str(), previousStateString.c_str());
+        LOG_DEBUG("newState, previousState: %s, %s", stateString.c_str(), previousStateString.c_str());
     }
 }
 
@@ -0,0 +1,94 @@
+#include "FrameArena.h"
+#include "constants.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+FrameArena::FrameArena()
+{
+    used = 0;
+    overflowBytes = 0;
+    peak = 0;
+    depth = 0;
+}
+
+FrameArena::~FrameArena()
+{
+    rewind(0, 0);
+}
+
+std::pmr::memory_resource* FrameArena::resource()
+{
+    FrameArena& arena = get();
+    return arena.depth ? &arena : std::pmr::new_delete_resource();
+}
+
+size_t FrameArena::getCapacity()
+{
+    return buffer.size();
+}
+
+void FrameArena::rewind(size_t mark, size_t overflowMark)
+{
+    for (size_t i = overflowMark; i < overflow.size(); i++)
+    {
+        std::pmr::new_delete_resource()->deallocate(overflow[i].pointer, overflow[i].bytes, overflow[i].alignment);
+        overflowBytes -= overflow[i].bytes;
+    }
+    overflow.resize(overflowMark);
+    used = mark;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    assert(depth > 0); // SANITY, a container outlived the scope it was filled in
+
+    if (buffer.empty()) // most threads never open a scope, don't make them pay for a buffer
+        buffer.resize(constants::FRAME_ARENA_INITIAL_SIZE);
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(buffer.data());
+    size_t start = ((base + used + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+    if (start + bytes <= buffer.size())
+    {
+        used = start + bytes;
+        peak = std::max(peak, used + overflowBytes);
+        return buffer.data() + start;
+    }
+
+    void* pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    overflow.push_back({ pointer, bytes, alignment });
+    overflowBytes += bytes;
+    peak = std::max(peak, used + overflowBytes);
+    return pointer;
+}
+
+void FrameArena::do_deallocate(void* /*pointer*/, size_t /*bytes*/, size_t /*alignment*/)
+{
+    // released all at once when the scope closes
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+FrameArena::Scope::Scope()
+    : arena(FrameArena::get())
+{
+    mark = arena.used;
+    overflowMark = arena.overflow.size();
+    arena.depth++;
+}
+
+FrameArena::Scope::~Scope()
+{
+    arena.rewind(mark, overflowMark);
+    if (--arena.depth > 0)
+        return;
+
+    // nothing is allocated anymore, make room for everything the last tick needed at once
+    if (arena.peak > arena.buffer.size())
+        std::vector<std::byte>(std::max(arena.peak, arena.buffer.size() * 2)).swap(arena.buffer);
+    arena.peak = 0;
+}
@@ -0,0 +1,227 @@
+#include "GameDataBundle.h"
+#include "MapGenerator.h"
+#include "Logger.h"
+
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+GameDataBundle::GameDataBundle()
+{
+    data = nullptr;
+    size = 0;
+}
+
+GameDataBundle::~GameDataBundle()
+{
+    close();
+}
+
+bool GameDataBundle::open(std::string filename)
+{
+    if (isOpen())
+    {
+        LOG_WARNING("game data bundle %s is already open", this->filename.c_str());
+        return false;
+    }
+
+    std::error_code error;
+    modified = std::filesystem::last_write_time(filename, error);
+    if (error)
+    {
+        LOG_DEBUG("no game data bundle at %s, using the json files", filename.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+
+    buffer.resize(file.tellg());
+    file.seekg(0);
+    file.read(buffer.data(), buffer.size());
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping stays valid
+    if (mapped == MAP_FAILED)
+        return false;
+
+    data = static_cast<const char*>(mapped);
+    size = status.st_size;
+#endif
+
+    this->filename = filename;
+    if (!validate())
+    {
+        close();
+        return false;
+    }
+
+    const BundleHeader& header = getHeader();
+    LOG_INFO("loaded game data bundle %s: %u actions, %u maps, %zu bytes", filename.c_str(), header.nrOfActions, header.nrOfMaps, size);
+    return true;
+}
+
+void GameDataBundle::close()
+{
+#ifndef _WIN32
+    if (data && buffer.empty())
+        munmap(const_cast<char*>(data), size);
+#endif
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+}
+
+bool GameDataBundle::validate()
+{
+    auto inside = [this](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset && offset % 8 == 0; };
+
+    if (size < sizeof(BundleHeader))
+    {
+        LOG_WARNING("game data bundle %s is truncated, using the json files", filename.c_str());
+        return false;
+    }
+
+    const BundleHeader& header = getHeader();
+    if (memcmp(header.magic, "TVEB", 4) != 0 || header.endianness != GAME_DATA_BUNDLE_ENDIANNESS)
+    {
+        LOG_WARNING("%s is not a game data bundle for this platform, using the json files", filename.c_str());
+        return false;
+    }
+
+    if (header.version != GAME_DATA_BUNDLE_VERSION || header.maxActions != MAX_ACTIONS)
+    {
+        LOG_WARNING("game data bundle %s is version %u with %u actions, expected version %u with %zu, recook it",
+            filename.c_str(), header.version, header.maxActions, GAME_DATA_BUNDLE_VERSION, MAX_ACTIONS);
+        return false;
+    }
+
+    bool valid = header.fileSize == size
+        && header.nrOfActions <= MAX_ACTIONS
+        && inside(header.stringsOffset, header.stringsSize)
+        && inside(header.actionsOffset, uint64_t(header.nrOfActions) * sizeof(BundleAction))
+        && inside(header.childOffsetsOffset, (uint64_t(header.nrOfActions) + 1) * sizeof(uint32_t))
+        && inside(header.childrenOffset, uint64_t(header.nrOfChildren) * sizeof(ActionId))
+        && inside(header.requirementsOffset, uint64_t(header.nrOfActions) * MAX_ACTIONS / 8)
+        && inside(header.mapsOffset, uint64_t(header.nrOfMaps) * sizeof(BundleMap));
+
+    for (uint32_t i = 0; valid && i < header.nrOfActions; i++)
+    {
+        const BundleAction& action = getActions()[i];
+        valid = uint64_t(action.key.offset) + action.key.length <= header.stringsSize
+            && uint64_t(action.name.offset) + action.name.length <= header.stringsSize
+            && action.type <= ACTION_FILLER;
+    }
+
+    for (uint32_t i = 0; valid && i < header.nrOfChildren; i++)
+        valid = getChildren()[i] < header.nrOfActions;
+
+    for (uint32_t i = 0; valid && i <= header.nrOfActions; i++)
+        valid = getChildOffsets()[i] <= header.nrOfChildren && (i == 0 || getChildOffsets()[i - 1] <= getChildOffsets()[i]);
+
+    const BundleMap* maps = reinterpret_cast<const BundleMap*>(data + header.mapsOffset);
+    for (uint32_t i = 0; valid && i < header.nrOfMaps; i++)
+    {
+        const BundleMap& map = maps[i];
+        valid = map.width > 0 && map.height > 0
+            && uint64_t(map.filename.offset) + map.filename.length <= header.stringsSize
+            && inside(map.tilesOffset, uint64_t(map.nrOfLayers) * map.width * map.height * sizeof(int32_t));
+    }
+
+    if (!valid)
+        LOG_WARNING("game data bundle %s is corrupt, using the json files", filename.c_str());
+
+    return valid;
+}
+
+bool GameDataBundle::isOpen() const
+{
+    return data != nullptr;
+}
+
+bool GameDataBundle::isFresh(const std::string& sourceFilename) const
+{
+    std::error_code error;
+    std::filesystem::file_time_type sourceModified = std::filesystem::last_write_time(sourceFilename, error);
+    if (error) // only the bundle was shipped
+        return true;
+
+    if (sourceModified > modified)
+    {
+        LOG_WARNING("%s changed after %s was cooked, using the json file", sourceFilename.c_str(), filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+const BundleHeader& GameDataBundle::getHeader() const
+{
+    return *reinterpret_cast<const BundleHeader*>(data);
+}
+
+std::string GameDataBundle::getString(BundleString string) const
+{
+    return std::string(data + getHeader().stringsOffset + string.offset, string.length);
+}
+
+const BundleAction* GameDataBundle::getActions() const
+{
+    return reinterpret_cast<const BundleAction*>(data + getHeader().actionsOffset);
+}
+
+const uint32_t* GameDataBundle::getChildOffsets() const
+{
+    return reinterpret_cast<const uint32_t*>(data + getHeader().childOffsetsOffset);
+}
+
+const ActionId* GameDataBundle::getChildren() const
+{
+    return reinterpret_cast<const ActionId*>(data + getHeader().childrenOffset);
+}
+
+const uint64_t* GameDataBundle::getRequirements(ActionId id) const
+{
+    return reinterpret_cast<const uint64_t*>(data + getHeader().requirementsOffset) + size_t(id) * MAX_ACTIONS / 64;
+}
+
+bool GameDataBundle::loadMap(const std::string& filename, MapTemplate& mapTemplate) const
+{
+    const BundleHeader& header = getHeader();
+    const BundleMap* maps = reinterpret_cast<const BundleMap*>(data + header.mapsOffset);
+    for (uint32_t i = 0; i < header.nrOfMaps; i++)
+    {
+        if (getString(maps[i].filename) != filename)
+            continue;
+
+        // the tiles are used straight from the mapping, nothing is copied
+        mapTemplate.gridSize = { maps[i].width, maps[i].height };
+        mapTemplate.nrOfLayers = maps[i].nrOfLayers;
+        mapTemplate.tiles = reinterpret_cast<const int32_t*>(data + maps[i].tilesOffset);
+        mapTemplate.storage.clear();
+        return true;
+    }
+
+    return false;
+}
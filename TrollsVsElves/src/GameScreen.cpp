@@ -1,22 +1,27 @@
 #include "GameScreen.h"
 #include "NetworkManager.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "AllocationCounter.h"
 
 GameScreen::GameScreen(Vector2i screenSize, bool isSinglePlayer)
 {
     this->screenSize = screenSize;
     this->networkManager = nullptr;
 
-    ActionsManager::get().loadRequirements("requirements.json");
-    ActionsManager::get().loadActions("actions.json");
+    ActionsManager::get().load("requirements.json", "actions.json");
 
     mapGenerator = new MapGenerator();
     mapGenerator->generateFromFile("map/map.json");
     Vector2i gridSize = mapGenerator->gridSize;
     Vector3 cubeSize = mapGenerator->cubeSize;
 
-    buildingManager = new BuildingManager({ cubeSize.x * 2, cubeSize.y, cubeSize.z * 2 }, BLANK, mapGenerator);
+    cameraManager = new CameraManager();
+    renderer = new InstancedRenderer();
 
-    playerManager = new PlayerManager(buildingManager, mapGenerator);
+    buildingManager = new BuildingManager({ cubeSize.x * 2, cubeSize.y, cubeSize.z * 2 }, BLANK, mapGenerator, cameraManager);
+
+    playerManager = new PlayerManager(buildingManager, mapGenerator, cameraManager);
     if (isSinglePlayer)
     {
         Vector3 startPos = { 0.f, cubeSize.y / 2, 0.f };
@@ -28,6 +33,8 @@ GameScreen::GameScreen(Vector2i screenSize, bool isSinglePlayer)
     }
 
     isMultiSelecting = false;
+    showCullingStats = false;
+    tick = 0;
 
     lastLeftMouseButtonClick = std::chrono::steady_clock::now();
 
@@ -41,51 +48,65 @@ GameScreen::~GameScreen()
 
     if (playerManager)
         delete playerManager;
+
+    if (mapGenerator)
+        delete mapGenerator;
+
+    if (cameraManager)
+        delete cameraManager;
+
+    if (renderer)
+        delete renderer;
 }
 
 void GameScreen::draw()
 {
-    CameraManager& cameraManager = CameraManager::get();
+    Frustum frustum = cameraManager->getFrustum();
 
-    BeginMode3D(cameraManager.getCamera());
+    BeginMode3D(cameraManager->getCamera());
 
-        mapGenerator->draw();
+        {
+            PROFILE_ZONE("MapGenerator::draw");
+            cullingStats.chunks = mapGenerator->draw(frustum); // first, the others use its visible chunks
+        }
 
         if (buildingManager)
-            buildingManager->draw();
+        {
+            PROFILE_ZONE("BuildingManager::draw");
+            cullingStats.buildings = buildingManager->draw(frustum, *renderer);
+        }
 
         if (playerManager)
-            playerManager->draw();
+        {
+            PROFILE_ZONE("PlayerManager::draw");
+            cullingStats.players = playerManager->draw(frustum, *renderer);
+        }
+
+        cullingStats.instancedDrawCalls = renderer->flush();
+        if (buildingManager)
+            buildingManager->drawGhost();
 
-        bool shouldDrawActionWindow = (buildingManager->selectedIndex == -1 != !playerManager->selectedPlayer); // xor
+        bool shouldDrawActionWindow = (!buildingManager->getSelectedBuilding() != !playerManager->selectedPlayer); // xor
         if (shouldDrawActionWindow) // xor
         {
-            size_t nrOfButtons = 4;
-            std::vector<ActionNode> actions = buildingManager->selectedIndex != -1
-                ? buildingManager->getActions(buildingManager->buildings[buildingManager->selectedIndex], nrOfButtons)
-                : playerManager->selectedPlayer->getActions(nrOfButtons);
-
-            UIManager::drawActionButtons(actions, screenSize);
+            UIManager::drawActionButtons(getActionButtons(4), screenSize);
         }
 
     EndMode3D();
 
-    BeginMode2D(cameraManager.getCamera2D());
+    BeginMode2D(cameraManager->getCamera2D());
 
         if (isMultiSelecting)
         {
             DrawRectangleRec(multiSelectionRectangle, { 0, 255, 0, 25 });
             DrawRectangleLinesEx(multiSelectionRectangle, 1.f, { 0, 255, 0, 50 });
 
-            std::vector<Player*>& players = playerManager->players;
-
             if (true) // set to true to draw all entities' capsule collision circles
             {
-                for (Player* player: players)
+                for (const ScreenCapsule& screenCapsule: playerManager->screenCapsules)
                 {
-                    Capsule& capsule = player->capsule;
-                    Circle bottom = cameraManager.convertSphereToCircle(capsule.startPos, capsule.radius);
-                    Circle top = cameraManager.convertSphereToCircle(capsule.endPos, capsule.radius);
+                    const Circle& bottom = screenCapsule.bottom;
+                    const Circle& top = screenCapsule.top;
 
                     DrawCircleV(bottom.position, bottom.radius, YELLOW);
                     DrawCircleLinesV(bottom.position, bottom.radius, GRAY);
@@ -99,37 +120,128 @@ void GameScreen::draw()
     EndMode2D();
 }
 
+const std::vector<ActionNode>& GameScreen::getActionButtons(size_t nrOfButtons)
+{
+    const void* owner;
+    ActionId actionId;
+    uint64_t unlockedActionsVersion = 0;
+    Building* building = buildingManager->getSelectedBuilding();
+    if (building)
+    {
+        owner = building;
+        actionId = building->actionId;
+        unlockedActionsVersion = buildingManager->unlockedActionsVersion; // only building buttons can be disabled
+    }
+    else
+    {
+        owner = playerManager->selectedPlayer;
+        actionId = playerManager->selectedPlayer->actionId;
+    }
+
+    if (owner != actionPanel.owner || buildingManager->selected != actionPanel.building
+    ||  actionId != actionPanel.actionId || unlockedActionsVersion != actionPanel.unlockedActionsVersion)
+    {
+        PROFILE_ZONE("GameScreen::getActionButtons");
+        actionPanel.owner = owner;
+        actionPanel.building = buildingManager->selected;
+        actionPanel.actionId = actionId;
+        actionPanel.unlockedActionsVersion = unlockedActionsVersion;
+        actionPanel.buttons = building
+            ? buildingManager->getActions(buildingManager->selected, nrOfButtons)
+            : playerManager->selectedPlayer->getActions(nrOfButtons);
+    }
+
+    return actionPanel.buttons;
+}
+
 void GameScreen::update()
 {
-    Task task;
-    while (messageQueue.pop(task))
-        task();
+    FrameArena::Scope frame; // transient allocations of the whole frame, input handling included, end here
+    uint64_t heapAllocations = getHeapAllocationCount();
 
-    CameraManager::get().update();
-    buildingManager->update();
-    playerManager->update();
+    updateSimulation();
+    handleInput();
+
+    tickTimings.heapAllocations = getHeapAllocationCount() - heapAllocations;
+}
+
+void GameScreen::updateSimulation()
+{
+    auto timestamp = std::chrono::steady_clock::now();
+    auto lap = [&timestamp]() {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - timestamp).count();
+        timestamp = now;
+        return elapsed;
+    };
+
+    {
+        PROFILE_ZONE("GameScreen::messages");
+        Task task;
+        while (messageQueue.pop(task))
+            task();
+    }
+    tickTimings.messages = lap();
+
+    {
+        PROFILE_ZONE("BuildingManager::update");
+        buildingManager->update();
+    }
+    tickTimings.buildingManager = lap();
+
+    {
+        PROFILE_ZONE("PlayerManager::update");
+        playerManager->update();
+    }
+    tickTimings.playerManager = lap();
+
+    tick++;
+    publishSnapshot();
+}
+
+void GameScreen::publishSnapshot()
+{
+    PROFILE_ZONE("GameScreen::publishSnapshot");
+    WorldSnapshot& snapshot = snapshots.beginPublish();
+    snapshot.tick = tick;
+    snapshot.nrOfBuildings = buildingManager->buildings.size();
+    snapshot.players.clear(); // keeps its capacity from two ticks ago
+    for (Player* player: playerManager->players)
+        snapshot.players.push_back({ player->GetNetworkID(), player->playerType, player->getPosition() });
+
+    snapshots.endPublish();
+}
+
+void GameScreen::handleInput()
+{
+    InputManager& inputManager = InputManager::get();
+    auto start = std::chrono::steady_clock::now();
+
+    cameraManager->update();
+    playerManager->updateScreenCapsules();
 
     if (!isMultiSelecting)
     {
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) // LMB was clicked this frame
+        if (inputManager.isMouseButtonPressed(MOUSE_BUTTON_LEFT)) // LMB was clicked this frame
             handleLeftMouseButton();
     }
     else
     {
-        if (IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+        if (inputManager.isMouseButtonDown(MOUSE_BUTTON_LEFT))
             updateMultiSelection();
-        else if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+        else if (inputManager.isMouseButtonReleased(MOUSE_BUTTON_LEFT))
             stopMultiSelection();
     }
 
-    if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT))
+    if (inputManager.isMouseButtonPressed(MOUSE_BUTTON_RIGHT))
         handleRightMouseButton();
+    tickTimings.input = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
 void GameScreen::startMultiSelection()
 {
     isMultiSelecting = true;
-    multiSelectionStartPosition = GetMousePosition();
+    multiSelectionStartPosition = InputManager::get().getMousePosition();
     updateMultiSelection();
 }
 
@@ -137,28 +249,14 @@ void GameScreen::stopMultiSelection()
 {
     isMultiSelecting = false;
 
-    CameraManager& cameraManager = CameraManager::get();
-    std::vector<Player*> players = playerManager->players;
-
-    for (Player* player: players)
-    {
-        Capsule& capsule = player->capsule;
-        Circle bottom = cameraManager.convertSphereToCircle(capsule.startPos, capsule.radius);
-        Circle top = cameraManager.convertSphereToCircle(capsule.endPos, capsule.radius);
-
-        // TODO: add collision against cylinder bounding box lines
-        if (CheckCollisionCircleRec(bottom.position, bottom.radius, multiSelectionRectangle)
-        ||  CheckCollisionCircleRec(top.position, top.radius, multiSelectionRectangle))
-        {
-            playerManager->deselect();
-            playerManager->select(player);
-        }
-    }
+    // clicking the ground to start the rectangle already cleared the selection
+    for (Player* player: playerManager->getPlayersInRectangle(multiSelectionRectangle))
+        playerManager->select(player);
 }
 
 void GameScreen::updateMultiSelection()
 {
-    Vector2 mousePos = GetMousePosition();
+    Vector2 mousePos = InputManager::get().getMousePosition();
     Vector2 direction = Vector2Subtract(mousePos, multiSelectionStartPosition);
 
     if (direction.y >= 0) // draw from multiSelectionStartPosition.y to direction.y
@@ -186,18 +284,18 @@ void GameScreen::updateMultiSelection()
 
 RayCollisionObject GameScreen::raycastWorld()
 {
-    std::variant<std::monostate, Player*, Entity*, Building*, Cube*> variant;
+    std::variant<std::monostate, Player*, Entity*, BuildingHandle, Cube> variant;
     if (ImGui::GetIO().WantCaptureMouse)
         return RayCollisionObject{ RAYCAST_HIT_TYPE_UI };
 
     if (Player* player = playerManager->raycastToPlayer())
         return RayCollisionObject{ RAYCAST_HIT_TYPE_PLAYER, (variant = player) };
 
-    if (Building* building = buildingManager->raycastToBuilding())
+    if (BuildingHandle building = buildingManager->raycastToBuilding(); building.isValid())
         return RayCollisionObject{ RAYCAST_HIT_TYPE_BUILDING, (variant = building) };
 
-    if (Cube* cube = mapGenerator->raycastToGround())
-        return RayCollisionObject{ RAYCAST_HIT_TYPE_GROUND, (variant = cube) };
+    if (std::optional<Cube> cube = mapGenerator->raycastToGround(cameraManager->getMouseRay()))
+        return RayCollisionObject{ RAYCAST_HIT_TYPE_GROUND, (variant = *cube) };
 
     return RayCollisionObject{ RAYCAST_HIT_TYPE_OUT_OF_BOUNDS };
 }
@@ -213,7 +311,7 @@ void GameScreen::handleLeftMouseButton()
     RaycastHitType type = raycastHit.type;
 
     // deselect selectedBuilding if not clicking UI
-    if (buildingManager->selectedIndex != -1 && type != RAYCAST_HIT_TYPE_UI)
+    if (buildingManager->getSelectedBuilding() && type != RAYCAST_HIT_TYPE_UI)
         buildingManager->deselect();
 
     // always clear selectedEntities if clicked player/entity/building
@@ -234,26 +332,14 @@ void GameScreen::handleLeftMouseButton()
             break;
 
         case RAYCAST_HIT_TYPE_BUILDING:
-            buildingManager->select(std::get<Building*>(raycastHit.object));
+            buildingManager->select(std::get<BuildingHandle>(raycastHit.object));
             break;
 
         case RAYCAST_HIT_TYPE_GROUND:
         {
             if (playerManager->clientPlayer->selected && buildingManager->ghost.exists())
             {
-                if (buildingManager->ghost.isColliding) // can't schedule ghostbuilding
-                    break;
-
-                Building& ghost = buildingManager->ghost.get();
-                bool buildingsInQueue = buildingManager->buildQueueFront() != nullptr;
-                buildingManager->scheduleGhostBuilding();
-                if (buildingsInQueue) // something is getting built, just schedule and leave player unchanged
-                    break;
-
-                Player* player = playerManager->clientPlayer;
-                player->reachedDestination = false;
-                Vector3 targetPosition = playerManager->calculateTargetPositionToCubeFromPlayer(player, ghost.cube);
-                playerManager->pathfindPlayerToPosition(player, targetPosition);
+                buildGhostBuilding(playerManager->clientPlayer);
                 break;
             }
 
@@ -276,31 +362,17 @@ void GameScreen::handleRightMouseButton()
     {
         case RAYCAST_HIT_TYPE_GROUND:
         {
-            Cube* cube = std::get<Cube*>(raycastHit.object);
+            Cube& cube = std::get<Cube>(raycastHit.object);
             if (playerManager->clientPlayer->selected) // only allow moving client owned player
             {
-                buildingManager->ghost.reset();
-                buildingManager->clearBuildQueue();
-
-                Vector3 pos = mapGenerator->worldPositionAdjusted(cube->position);
-                Player* player = playerManager->clientPlayer;
-
-                playerManager->pathfindPlayerToPosition(player, pos);
-
-                if (networkManager->isClient())
-                {
-                    networkManager->messageQueue.push(
-                        [this, player, pos]() { this->networkManager->sendPlayerRMBRequest(player, pos); }
-                    );
-                }
-
+                movePlayer(playerManager->clientPlayer, mapGenerator->worldPositionAdjusted(cube.position));
                 break;
             }
 
-            if (buildingManager->selectedIndex != -1)
+            if (Building* building = buildingManager->getSelectedBuilding())
             {
-                Vector3 adjusted = mapGenerator->worldPositionAdjusted(cube->position);
-                buildingManager->buildings[buildingManager->selectedIndex].rallyPoint.position = adjusted;
+                Vector3 adjusted = mapGenerator->worldPositionAdjusted(cube.position);
+                building->rallyPoint.position = adjusted;
 
                 break;
             }
@@ -315,3 +387,35 @@ void GameScreen::handleRightMouseButton()
             break;
     }
 }
+
+void GameScreen::movePlayer(Player* player, Vector3 position)
+{
+    buildingManager->ghost.reset();
+    buildingManager->clearBuildQueue(player);
+
+    playerManager->requestPath(player, position);
+
+    if (networkManager && networkManager->isClient())
+    {
+        networkManager->messageQueue.push(
+            [this, player, position]() { this->networkManager->sendPlayerRMBRequest(player, position); }
+        );
+    }
+}
+
+bool GameScreen::buildGhostBuilding(Player* player)
+{
+    if (!buildingManager->ghost.exists() || buildingManager->ghost.isColliding) // can't schedule ghostbuilding
+        return false;
+
+    Cube cube = buildingManager->ghost.get().cube; // copy, the ghost is reset when scheduled
+    bool buildingsInQueue = buildingManager->buildQueueFront(player) != nullptr;
+    buildingManager->scheduleGhostBuilding();
+    if (buildingsInQueue) // something is getting built, just schedule and leave player unchanged
+        return true;
+
+    player->reachedDestination = false;
+    Vector3 targetPosition = playerManager->calculateTargetPositionToCubeFromPlayer(player, cube);
+    playerManager->requestPath(player, targetPosition);
+    return true;
+}
@@ -0,0 +1,61 @@
+#include "InputManager.h"
+
+InputManager::InputManager()
+{
+    simulated = false;
+}
+
+void InputManager::setSimulated(bool simulated)
+{
+    this->simulated = simulated;
+}
+
+bool InputManager::isSimulated()
+{
+    return simulated;
+}
+
+SimulatedInput& InputManager::getSimulatedInput()
+{
+    return simulatedInput;
+}
+
+Vector2 InputManager::getMousePosition()
+{
+    return simulated ? simulatedInput.mousePosition : GetMousePosition();
+}
+
+float InputManager::getMouseWheelMove()
+{
+    return simulated ? simulatedInput.mouseWheelMove : GetMouseWheelMove();
+}
+
+float InputManager::getFrameTime()
+{
+    return simulated ? simulatedInput.frameTime : GetFrameTime();
+}
+
+bool InputManager::isMouseButtonPressed(int button)
+{
+    return simulated ? simulatedInput.mouseButtonsPressed.count(button) != 0 : IsMouseButtonPressed(button);
+}
+
+bool InputManager::isMouseButtonDown(int button)
+{
+    return simulated ? simulatedInput.mouseButtonsDown.count(button) != 0 : IsMouseButtonDown(button);
+}
+
+bool InputManager::isMouseButtonReleased(int button)
+{
+    return simulated ? simulatedInput.mouseButtonsReleased.count(button) != 0 : IsMouseButtonReleased(button);
+}
+
+bool InputManager::isKeyPressed(int key)
+{
+    return simulated ? simulatedInput.keysPressed.count(key) != 0 : IsKeyPressed(key);
+}
+
+bool InputManager::isKeyDown(int key)
+{
+    return simulated ? simulatedInput.keysDown.count(key) != 0 : IsKeyDown(key);
+}
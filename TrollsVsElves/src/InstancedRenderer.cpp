@@ -0,0 +1,175 @@
+#include "InstancedRenderer.h"
+#include "Profiler.h"
+
+// only translation is instanced, the normals don't need the instance transform
+static const char* vertexShader = R"(
+#version 330
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+in mat4 instanceTransform;
+uniform mat4 mvp;
+out vec3 fragNormal;
+
+void main()
+{
+    fragNormal = vertexNormal;
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+}
+)";
+
+// a fixed light instead of the wires drawCube and drawCapsule add, so the shapes stay readable
+static const char* fragmentShader = R"(
+#version 330
+in vec3 fragNormal;
+uniform vec4 colDiffuse;
+out vec4 finalColor;
+
+void main()
+{
+    float light = 0.6 + 0.4 * max(dot(normalize(fragNormal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+    finalColor = vec4(colDiffuse.rgb * light, colDiffuse.a);
+}
+)";
+
+// spheres around the start (y = 0) and the end (y = height) joined by a cylinder, like DrawCapsule
+static Mesh genMeshCapsule(float radius, float height, int slices, int rings)
+{
+    int nrOfRows = 2 * (rings + 1);
+    int rowSize = slices + 1;
+
+    Mesh mesh = {};
+    mesh.vertexCount = nrOfRows * rowSize;
+    mesh.triangleCount = (nrOfRows - 1) * slices * 2;
+    mesh.vertices = (float*)MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+    mesh.normals = (float*)MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+    mesh.indices = (unsigned short*)MemAlloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+
+    int vertex = 0;
+    for (int row = 0; row < nrOfRows; row++)
+    {
+        bool top = row > rings;
+        float phi = top
+            ? (PI / 2) * (row - rings - 1) / rings      // equator to the top pole
+            : (PI / 2) * row / rings - PI / 2;          // bottom pole to the equator
+        float centerY = top ? height : 0.f;
+
+        for (int slice = 0; slice <= slices; slice++, vertex++)
+        {
+            float theta = 2 * PI * slice / slices;
+            Vector3 normal = { cosf(phi) * cosf(theta), sinf(phi), cosf(phi) * sinf(theta) };
+            mesh.normals[vertex * 3 + 0] = normal.x;
+            mesh.normals[vertex * 3 + 1] = normal.y;
+            mesh.normals[vertex * 3 + 2] = normal.z;
+            mesh.vertices[vertex * 3 + 0] = normal.x * radius;
+            mesh.vertices[vertex * 3 + 1] = normal.y * radius + centerY;
+            mesh.vertices[vertex * 3 + 2] = normal.z * radius;
+        }
+    }
+
+    int index = 0;
+    for (int row = 0; row < nrOfRows - 1; row++)
+    {
+        for (int slice = 0; slice < slices; slice++)
+        {
+            unsigned short bottomLeft = row * rowSize + slice;
+            unsigned short bottomRight = bottomLeft + 1;
+            unsigned short topLeft = bottomLeft + rowSize;
+            unsigned short topRight = topLeft + 1;
+
+            // counter-clockwise seen from outside
+            for (unsigned short i: { bottomLeft, topLeft, bottomRight, bottomRight, topLeft, topRight })
+                mesh.indices[index++] = i;
+        }
+    }
+
+    UploadMesh(&mesh, false);
+    return mesh;
+}
+
+InstancedRenderer::InstancedRenderer()
+{
+    loaded = false;
+}
+
+InstancedRenderer::~InstancedRenderer()
+{
+    if (!loaded)
+        return;
+
+    for (Mesh& mesh: meshes)
+        UnloadMesh(mesh);
+    UnloadMaterial(material); // unloads the shader as well
+}
+
+void InstancedRenderer::load()
+{
+    shader = LoadShaderFromMemory(vertexShader, fragmentShader);
+    shader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(shader, "mvp");
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
+
+    material = LoadMaterialDefault();
+    material.shader = shader;
+    loaded = true;
+}
+
+void InstancedRenderer::add(size_t meshIndex, Color color, Vector3 position)
+{
+    uint32_t packedColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
+    Batch& batch = batches[{ meshIndex, packedColor }];
+    batch.meshIndex = meshIndex;
+    batch.color = color;
+    batch.transforms.push_back(MatrixTranslate(position.x, position.y, position.z));
+}
+
+void InstancedRenderer::addCube(const Cube& cube)
+{
+    auto key = std::make_tuple(cube.size.x, cube.size.y, cube.size.z);
+    auto found = cubeMeshes.find(key);
+    if (found == cubeMeshes.end())
+    {
+        found = cubeMeshes.insert({ key, meshes.size() }).first;
+        meshes.push_back(GenMeshCube(cube.size.x, cube.size.y, cube.size.z)); // centered, like DrawCubeV
+    }
+
+    add(found->second, cube.color, cube.position);
+}
+
+void InstancedRenderer::addCapsule(const Capsule& capsule)
+{
+    float height = capsule.endPos.y - capsule.startPos.y;
+    auto key = std::make_tuple(capsule.radius, height, capsule.slices, capsule.rings);
+    auto found = capsuleMeshes.find(key);
+    if (found == capsuleMeshes.end())
+    {
+        found = capsuleMeshes.insert({ key, meshes.size() }).first;
+        meshes.push_back(genMeshCapsule(capsule.radius, height, capsule.slices, capsule.rings));
+    }
+
+    add(found->second, capsule.color, capsule.startPos);
+}
+
+int InstancedRenderer::flush()
+{
+    PROFILE_ZONE("InstancedRenderer::flush");
+    if (!loaded)
+        load();
+
+    int drawCalls = 0;
+    for (auto it = batches.begin(); it != batches.end();)
+    {
+        Batch& batch = it->second;
+        if (batch.transforms.empty()) // unused for a frame, buildings in progress fade through lots of colors
+        {
+            it = batches.erase(it);
+            continue;
+        }
+
+        material.maps[MATERIAL_MAP_DIFFUSE].color = batch.color;
+        DrawMeshInstanced(meshes[batch.meshIndex], material, batch.transforms.data(), batch.transforms.size());
+        batch.transforms.clear();
+        drawCalls++;
+        it++;
+    }
+
+    return drawCalls;
+}
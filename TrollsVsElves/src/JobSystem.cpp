@@ -0,0 +1,222 @@
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+static thread_local JobSystem* currentSystem = nullptr;    // set on the workers only
+static thread_local size_t currentWorker = 0;
+
+JobSystem::JobSystem()
+{
+    queued = 0;
+    stopping = false;
+    start(std::max(1u, std::thread::hardware_concurrency()) - 1); // the waiting thread helps out
+}
+
+JobSystem::~JobSystem()
+{
+    stop();
+}
+
+void JobSystem::start(size_t nrOfWorkers)
+{
+    stopping = false;
+    queues.clear();
+    for (size_t i = 0; i < nrOfWorkers + 1; i++)
+        queues.push_back(std::make_unique<JobQueue>());
+
+    for (size_t i = 0; i < nrOfWorkers; i++)
+        workers.push_back(std::thread([this, i]() { work(i); }));
+}
+
+void JobSystem::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for (std::thread& worker: workers)
+        if (worker.joinable())
+            worker.join();
+    workers.clear();
+}
+
+void JobSystem::configure(size_t nrOfWorkers)
+{
+    assert(queued == 0); // SANITY, jobs would be lost with their queues
+
+    stop();
+    start(nrOfWorkers);
+}
+
+size_t JobSystem::getWorkerCount()
+{
+    return workers.size();
+}
+
+JobSystem::JobQueue& JobSystem::getOwnQueue()
+{
+    return currentSystem == this ? *queues[currentWorker] : *queues.back();
+}
+
+void JobSystem::submit(Task task, JobCounter& counter)
+{
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    JobQueue& queue = getOwnQueue();
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({ task, &counter });
+    }
+    queued.fetch_add(1);
+
+    // a worker checks queued while holding sleepMutex, taking it here means the worker is either asleep or will see the job
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    jobAvailable.notify_one();
+}
+
+bool JobSystem::runOne()
+{
+    if (queued.load() == 0)
+        return false;
+
+    bool isWorker = currentSystem == this;
+    size_t own = isWorker ? currentWorker : queues.size() - 1;
+
+    Job job;
+    bool found = false;
+    {
+        // workers take their newest job, it is the most likely to still be in cache. The shared queue
+        // is taken oldest first, which keeps submission order when there are no workers
+        JobQueue& queue = *queues[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            job = isWorker ? queue.jobs.back() : queue.jobs.front();
+            isWorker ? queue.jobs.pop_back() : queue.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size() && !found; i++) // steal the oldest job of someone else
+    {
+        JobQueue& victim = *queues[(own + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+        return false;
+
+    queued.fetch_sub(1);
+    {
+        FrameArena::Scope scope; // what a job takes from the arena of the thread it ran on is gone once it is done
+        job.task();
+    }
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    while (counter.pending.load(std::memory_order_acquire) > 0)
+        if (!runOne()) // the remaining jobs are running on other threads
+            std::this_thread::yield();
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body)
+{
+    grainSize = std::max<size_t>(grainSize, 1);
+    if (count <= grainSize || workers.empty())
+    {
+        for (size_t begin = 0; begin < count; begin += grainSize)
+            body(begin, std::min(begin + grainSize, count));
+        return;
+    }
+
+    PROFILE_ZONE("JobSystem::parallelFor");
+    struct Range
+    {
+        const std::function<void(size_t begin, size_t end)>& body;
+        size_t count;
+        size_t grainSize;
+    } range = { body, count, grainSize }; // two words fit in the inline storage of a Task, jobs skip the heap
+
+    JobCounter counter;
+    for (size_t begin = grainSize; begin < count; begin += grainSize)
+        submit([&range, begin]() { range.body(begin, std::min(begin + range.grainSize, range.count)); }, counter);
+
+    body(0, grainSize); // the caller takes the first range
+    wait(counter);
+}
+
+void JobSystem::work(size_t index)
+{
+    currentSystem = this;
+    currentWorker = index;
+    PROFILE_THREAD("job worker " + std::to_string(index));
+
+    while (true)
+    {
+        if (runOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        jobAvailable.wait(lock, [this]() { return stopping || queued.load() > 0; });
+        if (stopping)
+            return;
+    }
+}
+
+size_t JobGraph::add(Task task, std::initializer_list<size_t> dependencies)
+{
+    size_t index = nodes.size();
+    Node& node = nodes.emplace_back();
+    node.task = task;
+    node.dependencies = dependencies.size();
+
+    for (size_t dependency: dependencies)
+    {
+        assert(dependency < index); // SANITY, which also rules out cycles
+        nodes[dependency].successors.push_back(index);
+    }
+
+    return index;
+}
+
+void JobGraph::submit(size_t index, JobCounter& counter)
+{
+    JobSystem::get().submit([this, index, &counter]() {
+        Node& node = nodes[index];
+        node.task();
+
+        // submitted before this job counts as finished, so the counter can't reach zero in between
+        for (size_t successor: node.successors)
+            if (nodes[successor].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                submit(successor, counter);
+    }, counter);
+}
+
+void JobGraph::run()
+{
+    for (Node& node: nodes)
+        node.remaining.store(node.dependencies, std::memory_order_relaxed);
+
+    JobCounter counter;
+    for (size_t i = 0; i < nodes.size(); i++)
+        if (!nodes[i].dependencies)
+            submit(i, counter);
+
+    JobSystem::get().wait(counter);
+}
@@ -0,0 +1,147 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+
+int formatLogMessage(char* buffer, size_t size, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, size, format, args);
+    va_end(args);
+    return length;
+}
+
+Logger::Logger()
+{
+    // bounded MPMC queue (Vyukov), a slot is free for position p when its sequence equals p
+    slots = new Slot[CAPACITY];
+    for (size_t i = 0; i < CAPACITY; i++)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    enqueuePosition = 0;
+    dequeuePosition = 0;
+    writtenPosition = 0;
+    dropped = 0;
+    level = LOG_MIN_LEVEL;
+    epoch = 0;
+    epoch = now();
+
+    running = true;
+    thread = std::thread([this]() { run(); });
+}
+
+Logger::~Logger()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+
+    delete[] slots;
+}
+
+uint64_t Logger::now()
+{
+    auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count() - epoch;
+}
+
+uint32_t Logger::getThreadId()
+{
+    static std::atomic<uint32_t> nextThreadId { 0 };
+    thread_local uint32_t threadId = nextThreadId++;
+    return threadId;
+}
+
+LogRecord* Logger::beginRecord(size_t& position)
+{
+    position = enqueuePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot& slot = slots[position & (CAPACITY - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        intptr_t difference = intptr_t(sequence) - intptr_t(position);
+
+        if (difference == 0) // free, try to claim it
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                return &slot.record;
+        }
+        else if (difference < 0) // full, the flush thread hasn't caught up
+            return nullptr;
+        else // another thread claimed it first
+            position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+}
+
+void Logger::commitRecord(size_t position)
+{
+    slots[position & (CAPACITY - 1)].sequence.store(position + 1, std::memory_order_release);
+}
+
+size_t Logger::drain(std::string& output)
+{
+    static const char* levelNames[] = { "TRACE", "DEBUG", "INFO", "WARNING", "ERROR" };
+    char message[1024];
+    size_t count = 0;
+
+    while (true)
+    {
+        Slot& slot = slots[dequeuePosition & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) // not committed yet
+            break;
+
+        const LogRecord& record = slot.record;
+        int length = snprintf(message, sizeof(message), "[%10.4f] [%s] [%u] ",
+            record.timestamp / 1e9, levelNames[record.level], record.threadId);
+        output.append(message, std::min<size_t>(length, sizeof(message) - 1));
+
+        length = record.formatter
+            ? record.formatter(message, sizeof(message), record.format, record.data)
+            : snprintf(message, sizeof(message), "%s (arguments truncated)", record.format);
+        output.append(message, std::min<size_t>(std::max(length, 0), sizeof(message) - 1));
+        output.push_back('\n');
+
+        slot.sequence.store(dequeuePosition + CAPACITY, std::memory_order_release); // hand the slot back to the writers
+        dequeuePosition++;
+        count++;
+    }
+
+    uint64_t droppedCount = dropped.exchange(0, std::memory_order_relaxed);
+    if (droppedCount)
+        output += "[logger] dropped " + std::to_string(droppedCount) + " messages, the queue was full\n";
+
+    return count;
+}
+
+void Logger::run()
+{
+    std::string output;
+    while (true)
+    {
+        bool stopping = !running.load(); // read before draining so nothing logged before the stop is missed
+        output.clear();
+        size_t count = drain(output);
+
+        if (output.size())
+        {
+            fwrite(output.data(), 1, output.size(), stderr);
+            fflush(stderr);
+        }
+        writtenPosition.store(dequeuePosition, std::memory_order_release);
+
+        if (stopping)
+            break;
+
+        if (!count)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+void Logger::flush()
+{
+    size_t target = enqueuePosition.load(std::memory_order_acquire);
+    while (writtenPosition.load(std::memory_order_acquire) < target && running.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
@@ -1,62 +1,326 @@
 #include "MapGenerator.h"
+#include "GameDataBundle.h"
+#include "TiledMapReader.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cstring>
+#include <limits>
 
 MapGenerator::MapGenerator()
 {
     defaultCubeColor = DARKGRAY;
     cubeSize = Vector3Scale(Vector3One(), 4.f);
     height = 0.f;
+    pathfindingTime = 0.0;
+    pathfindingQueries = 0;
+    nrOfChunks = { 0, 0 };
+    hasChunkMaterial = false;
+
+    searchOptions.variant = AStar::SEARCH_ASTAR;
+    searchOptions.maxExpansions = constants::PATHFINDING_MAX_EXPANSIONS; // bounds the worst-case cost of a single query
+    searchOptions.smoothPath = true; // only corner waypoints end up in Entity::path and path corrections
 }
 
-MapGenerator::~MapGenerator() {}
+MapGenerator::~MapGenerator()
+{
+    for (MapChunk& chunk: chunks)
+        if (chunk.hasMesh && chunk.mesh.triangleCount)
+            UnloadMesh(chunk.mesh);
+
+    if (hasChunkMaterial)
+        UnloadMaterial(chunkMaterial);
+}
 
-void MapGenerator::draw()
+DrawCounts MapGenerator::draw(const Frustum& frustum)
 {
-    for (Cube& cube: grid)
+    if (!hasChunkMaterial)
+    {
+        chunkMaterial = LoadMaterialDefault();
+        hasChunkMaterial = true;
+    }
+
+    DrawCounts counts;
+    int nrOfBuiltMeshes = 0;
+    float margin = constants::MAP_CHUNK_CULLING_MARGIN * cubeSize.x;
+    visibleChunks.assign(chunks.size(), false);
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        MapChunk& chunk = chunks[i];
+
+        // anything standing in the chunk is within the margin, objects in hidden chunks are culled without a test of their own
+        BoundingBox objectBounds = {
+            { chunk.bounds.min.x - margin, chunk.bounds.min.y, chunk.bounds.min.z - margin },
+            { chunk.bounds.max.x + margin, chunk.bounds.max.y + margin, chunk.bounds.max.z + margin }
+        };
+        if (!isBoxInFrustum(frustum, objectBounds))
+        {
+            counts.culled++;
+            continue;
+        }
+        visibleChunks[i] = true;
+
+        if (!isBoxInFrustum(frustum, chunk.bounds))
+        {
+            counts.culled++;
+            continue;
+        }
+
+        if (!chunk.hasMesh)
+        {
+            if (nrOfBuiltMeshes == constants::MAP_CHUNK_MESHES_PER_FRAME) // the rest shows up over the next frames
+                continue;
+            buildChunkMesh(chunk);
+            nrOfBuiltMeshes++;
+        }
+
+        if (chunk.mesh.triangleCount)
+        {
+            DrawMesh(chunk.mesh, chunkMaterial, MatrixIdentity());
+            counts.submitted++;
+        }
+    }
+
+    for (Vector2i index: highlightedTiles)
+    {
+        if (getTile(index).type == TILE_EMPTY)
+            continue;
+
+        Cube cube = getTileCube(index);
+        cube.size = Vector3Scale(cube.size, 1.01f); // on top of the chunk mesh
+        cube.color = RED;
         drawCube(cube);
+    }
+
+    return counts;
+}
+
+bool MapGenerator::isVisible(const Frustum& frustum, BoundingBox bounds)
+{
+    Vector3 center = Vector3Scale(Vector3Add(bounds.min, bounds.max), 0.5f);
+    Vector2i index = worldPositionToIndex(center);
+    bool onMap = index.x >= 0 && index.x < gridSize.x && index.y >= 0 && index.y < gridSize.y;
+    if (onMap && visibleChunks.size())
+    {
+        const int chunkSize = constants::MAP_CHUNK_SIZE;
+        if (!visibleChunks[(index.y / chunkSize) * nrOfChunks.x + index.x / chunkSize])
+            return false;
+    }
+
+    return isBoxInFrustum(frustum, bounds);
+}
+
+std::shared_ptr<const MapTemplate> MapTemplateCache::load(std::string filename)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = templates.find(filename);
+    if (found != templates.end())
+        return found->second;
+
+    std::shared_ptr<MapTemplate> mapTemplate = std::make_shared<MapTemplate>();
+    GameDataBundle& bundle = GameDataBundle::get();
+    if (!bundle.isOpen() || !bundle.isFresh(filename) || !bundle.loadMap(filename, *mapTemplate))
+    {
+        TiledMapReader reader;
+        bool readSuccessful = reader.read(filename, *mapTemplate);
+        if (!readSuccessful)
+        {
+            LOG_ERROR("couldn't read map %s: %s", filename.c_str(), reader.getError().c_str());
+            Logger::get().flush(); // the assert aborts before the logger could write it
+            assert(readSuccessful);
+        }
+    }
+
+    templates[filename] = mapTemplate;
+    return mapTemplate;
 }
 
 void MapGenerator::generateFromFile(std::string filename)
 {
-    Json::Value json = parseJsonFile(filename);
+    generateFromTemplate(*MapTemplateCache::get().load(filename));
+}
 
-    gridSize = { json["width"].asInt(), json["height"].asInt() };
+void MapGenerator::generateFromTemplate(const MapTemplate& mapTemplate)
+{
+    gridSize = mapTemplate.gridSize;
+
+    const int chunkSize = constants::MAP_CHUNK_SIZE;
+    nrOfChunks = { (gridSize.x + chunkSize - 1) / chunkSize, (gridSize.y + chunkSize - 1) / chunkSize };
+    chunks = std::vector<MapChunk>(nrOfChunks.x * nrOfChunks.y);
+    for (int y = 0; y < nrOfChunks.y; y++)
+    {
+        for (int x = 0; x < nrOfChunks.x; x++)
+        {
+            MapChunk& chunk = chunks[y * nrOfChunks.x + x];
+            chunk.origin = { x * chunkSize, y * chunkSize };
+            chunk.size = { std::min(chunkSize, gridSize.x - chunk.origin.x), std::min(chunkSize, gridSize.y - chunk.origin.y) };
+            chunk.tiles = std::vector<MapTile>(chunk.size.x * chunk.size.y);
+        }
+    }
 
-    grid = std::vector<Cube>(gridSize.y * gridSize.x);
     obstacles = std::vector<std::vector<bool>>(gridSize.y, std::vector<bool>(gridSize.x, false));
     elfObstacles = std::vector<std::vector<bool>>(gridSize.y, std::vector<bool>(gridSize.x, false));
     trollObstacles = std::vector<std::vector<bool>>(gridSize.y/2, std::vector<bool>(gridSize.x/2, false));
+    highlightedTiles.clear();
 
-    Vector2 halfGridSize = { gridSize.x / 2 * cubeSize.x, gridSize.y / 2 * cubeSize.z };
-    float groundHeight = height - cubeSize.y/2;
-    float layerHeight = groundHeight;
-    float px, py;
-    int x, y, index, type;
-    for (Json::Value& layer: json["layers"])
+    int x, y, type;
+    for (int layerIndex = 0; layerIndex < mapTemplate.nrOfLayers; layerIndex++)
     {
+        const int32_t* layer = mapTemplate.getLayer(layerIndex);
         for (y = 0; y < gridSize.y; y++)
         {
             for (x = 0; x < gridSize.x; x++)
             {
-                index = twoDimToOneDimIndex({ x, y });
-                type = layer["data"][index].asInt();
+                type = layer[twoDimToOneDimIndex({ x, y })];
                 if (type == 0) // empty tile
                     continue;
 
-                px = cubeSize.x * x - halfGridSize.x;
-                py = cubeSize.y * y - halfGridSize.y;
-
-                grid[index] = Cube({ px, layerHeight, py }, cubeSize, defaultCubeColor);
+                MapChunk& chunk = chunks[(y / chunkSize) * nrOfChunks.x + x / chunkSize];
+                MapTile& tile = chunk.tiles[(y - chunk.origin.y) * chunk.size.x + x - chunk.origin.x];
+                tile.layer = uint8_t(layerIndex);
+                tile.type = TILE_GROUND;
 
                 if (type == 34) // obstruction tile
                 {
-                    grid[index].position.y = groundHeight; // put it on the ground so it looks "normal"
-                    addObstacle(grid[index]);
+                    tile.type = TILE_OBSTRUCTION;
+                    obstacles[y][x] = true;
                 }
             }
         }
+    }
 
-        layerHeight += cubeSize.y; // increment height with one cubeSize.y per layer
+    // the bounds only need the chunk's corners and its highest tile
+    float groundHeight = height - cubeSize.y/2;
+    for (MapChunk& chunk: chunks)
+    {
+        float top = groundHeight;
+        for (MapTile& tile: chunk.tiles)
+            if (tile.type == TILE_GROUND)
+                top = std::max(top, groundHeight + tile.layer * cubeSize.y);
+
+        Vector3 first = getTileCube(chunk.origin).position;
+        Vector3 last = getTileCube({ chunk.origin.x + chunk.size.x - 1, chunk.origin.y + chunk.size.y - 1 }).position;
+        chunk.bounds = {
+            { first.x - cubeSize.x/2, groundHeight - cubeSize.y/2, first.z - cubeSize.z/2 },
+            { last.x + cubeSize.x/2, top + cubeSize.y/2, last.z + cubeSize.z/2 }
+        };
     }
+
+    // once for all obstruction tiles instead of once per tile
+    recalculateObstacles();
+    recalculateTrollObstacles();
+    elfComponents.rebuild(elfObstacles);
+    trollComponents.rebuild(trollObstacles);
+}
+
+MapTile MapGenerator::getTile(Vector2i index)
+{
+    if (index.x < 0 || index.x >= gridSize.x || index.y < 0 || index.y >= gridSize.y)
+        return MapTile();
+
+    const int chunkSize = constants::MAP_CHUNK_SIZE;
+    MapChunk& chunk = chunks[(index.y / chunkSize) * nrOfChunks.x + index.x / chunkSize];
+    return chunk.tiles[(index.y - chunk.origin.y) * chunk.size.x + index.x - chunk.origin.x];
+}
+
+Cube MapGenerator::getTileCube(Vector2i index)
+{
+    MapTile tile = getTile(index);
+    if (tile.type == TILE_EMPTY)
+        return Cube();
+
+    float groundHeight = height - cubeSize.y/2;
+    Vector2 halfGridSize = { gridSize.x / 2 * cubeSize.x, gridSize.y / 2 * cubeSize.z };
+    Vector3 position = {
+        cubeSize.x * index.x - halfGridSize.x,
+        tile.type == TILE_OBSTRUCTION
+            ? groundHeight // put it on the ground so it looks "normal"
+            : groundHeight + tile.layer * cubeSize.y,
+        cubeSize.y * index.y - halfGridSize.y
+    };
+
+    return Cube(position, cubeSize, defaultCubeColor);
+}
+
+void MapGenerator::buildChunkMesh(MapChunk& chunk)
+{
+    PROFILE_ZONE("MapGenerator::buildChunkMesh");
+    static_assert(constants::MAP_CHUNK_SIZE * constants::MAP_CHUNK_SIZE * 5 * 4 <= 65536, "chunk meshes use 16 bit indices");
+
+    std::vector<float> vertices;
+    std::vector<unsigned char> colors;
+    std::vector<unsigned short> indices;
+
+    // counter-clockwise seen from outside the cube
+    auto addQuad = [&](Vector3 a, Vector3 b, Vector3 c, Vector3 d, Color color) {
+        unsigned short first = vertices.size() / 3;
+        for (Vector3 v: { a, b, c, d })
+        {
+            vertices.insert(vertices.end(), { v.x, v.y, v.z });
+            colors.insert(colors.end(), { color.r, color.g, color.b, color.a });
+        }
+        indices.insert(indices.end(), { first, (unsigned short)(first + 1), (unsigned short)(first + 2), first, (unsigned short)(first + 2), (unsigned short)(first + 3) });
+    };
+    auto shade = [](Color color, float amount) {
+        return Color{ (unsigned char)(color.r * amount), (unsigned char)(color.g * amount), (unsigned char)(color.b * amount), color.a };
+    };
+    auto topOf = [&](Vector2i index) {
+        if (getTile(index).type == TILE_EMPTY)
+            return -std::numeric_limits<float>::infinity();
+        Cube cube = getTileCube(index);
+        return cube.position.y + cube.size.y/2;
+    };
+
+    for (int y = chunk.origin.y; y < chunk.origin.y + chunk.size.y; y++)
+    {
+        for (int x = chunk.origin.x; x < chunk.origin.x + chunk.size.x; x++)
+        {
+            if (getTile({ x, y }).type == TILE_EMPTY)
+                continue;
+
+            BoundingBox box = getCubeBoundingBox(getTileCube({ x, y }));
+            Vector3 min = box.min;
+            Vector3 max = box.max;
+
+            // without lighting a checkerboard and darker sides keep the tiles apart, instead of drawing wires
+            Color color = (x + y) % 2 ? defaultCubeColor : shade(defaultCubeColor, 0.9f);
+            addQuad({ min.x, max.y, min.z }, { min.x, max.y, max.z }, { max.x, max.y, max.z }, { max.x, max.y, min.z }, color);
+
+            // sides only where the neighbour doesn't cover them
+            if (topOf({ x - 1, y }) < max.y)
+                addQuad({ min.x, min.y, min.z }, { min.x, min.y, max.z }, { min.x, max.y, max.z }, { min.x, max.y, min.z }, shade(color, 0.8f));
+            if (topOf({ x + 1, y }) < max.y)
+                addQuad({ max.x, min.y, min.z }, { max.x, max.y, min.z }, { max.x, max.y, max.z }, { max.x, min.y, max.z }, shade(color, 0.8f));
+            if (topOf({ x, y - 1 }) < max.y)
+                addQuad({ min.x, min.y, min.z }, { min.x, max.y, min.z }, { max.x, max.y, min.z }, { max.x, min.y, min.z }, shade(color, 0.65f));
+            if (topOf({ x, y + 1 }) < max.y)
+                addQuad({ min.x, min.y, max.z }, { max.x, min.y, max.z }, { max.x, max.y, max.z }, { min.x, max.y, max.z }, shade(color, 0.65f));
+        }
+    }
+
+    chunk.mesh = Mesh{};
+    chunk.hasMesh = true;
+    if (indices.empty())
+        return;
+
+    chunk.mesh.vertexCount = vertices.size() / 3;
+    chunk.mesh.triangleCount = indices.size() / 3;
+    chunk.mesh.vertices = (float*)MemAlloc(vertices.size() * sizeof(float));
+    chunk.mesh.colors = (unsigned char*)MemAlloc(colors.size());
+    chunk.mesh.indices = (unsigned short*)MemAlloc(indices.size() * sizeof(unsigned short));
+    memcpy(chunk.mesh.vertices, vertices.data(), vertices.size() * sizeof(float));
+    memcpy(chunk.mesh.colors, colors.data(), colors.size());
+    memcpy(chunk.mesh.indices, indices.data(), indices.size() * sizeof(unsigned short));
+    UploadMesh(&chunk.mesh, false);
+
+    // the buffers live on the GPU now, only keep the handles
+    MemFree(chunk.mesh.vertices);
+    MemFree(chunk.mesh.colors);
+    MemFree(chunk.mesh.indices);
+    chunk.mesh.vertices = nullptr;
+    chunk.mesh.colors = nullptr;
+    chunk.mesh.indices = nullptr;
 }
 
 void MapGenerator::recalculateObstacles()
@@ -110,22 +374,33 @@ void MapGenerator::recalculateTrollObstacles()
 
 void MapGenerator::addObstacle(Cube cube)
 {
-    std::vector<Vector2i> indices = getCubeIndices(cube);
+    std::pmr::vector<Vector2i> indices = getCubeIndices(cube);
     for (Vector2i index: indices)
         obstacles[index.y][index.x] = true;
 
-    recalculateObstacles();
-    recalculateTrollObstacles();
+    updateObstacleMaps();
 }
 
 void MapGenerator::removeObstacle(Cube cube)
 {
-    std::vector<Vector2i> indices = getCubeIndices(cube);
+    std::pmr::vector<Vector2i> indices = getCubeIndices(cube);
     for (Vector2i index: indices)
         obstacles[index.y][index.x] = false;
 
-    recalculateObstacles();
-    recalculateTrollObstacles();
+    updateObstacleMaps();
+}
+
+void MapGenerator::updateObstacleMaps()
+{
+    PROFILE_ZONE("MapGenerator::updateObstacleMaps");
+
+    // both maps only read obstacles, the elf and troll side don't wait for each other
+    JobGraph graph;
+    size_t elf = graph.add([this]() { recalculateObstacles(); });
+    size_t troll = graph.add([this]() { recalculateTrollObstacles(); });
+    graph.add([this]() { elfComponents.update(elfObstacles); }, { elf });
+    graph.add([this]() { trollComponents.update(trollObstacles); }, { troll });
+    graph.run();
 }
 
 int MapGenerator::twoDimToOneDimIndex(Vector2i index)
@@ -150,7 +425,7 @@ Vector2i MapGenerator::worldPositionToIndex(Vector3 position)
 
 Vector3 MapGenerator::indexToWorldPosition(Vector2i index)
 {
-    Cube& cube = grid[twoDimToOneDimIndex(index)];
+    Cube cube = getTileCube(index);
 
     Vector2i adjusted = {
         index.x - (gridSize.x/2),
@@ -170,13 +445,18 @@ Vector3 MapGenerator::worldPositionAdjusted(Vector3 position)
     return indexToWorldPosition(index);
 }
 
-std::vector<Vector2i> MapGenerator::getCubeIndices(Cube& cube)
+std::pmr::vector<Vector2i> MapGenerator::getCubeIndices(Cube& cube)
 {
     BoundingBox bb = getCubeBoundingBox(cube);
     Vector2i bottomLeft = worldPositionToIndex(bb.min);
     Vector2i topRight = worldPositionToIndex(bb.max);
 
-    std::vector<Vector2i> indices;
+    // buildings placed along the edge stick out of the map, only the part on the map has tiles
+    bottomLeft = { std::max(bottomLeft.x, 0), std::max(bottomLeft.y, 0) };
+    topRight = { std::min(topRight.x, gridSize.x), std::min(topRight.y, gridSize.y) };
+
+    std::pmr::vector<Vector2i> indices(FrameArena::resource());
+    indices.reserve(std::max(topRight.x - bottomLeft.x, 0) * std::max(topRight.y - bottomLeft.y, 0));
     for (int y = bottomLeft.y; y < topRight.y; ++y)     // exclusive for a reason
         for (int x = bottomLeft.x; x < topRight.x; ++x) // exclusive for a reason
             indices.push_back({ x, y });
@@ -184,12 +464,12 @@ std::vector<Vector2i> MapGenerator::getCubeIndices(Cube& cube)
     return indices;
 }
 
-std::vector<Vector2i> MapGenerator::getNeighboringIndices(std::vector<Vector2i> indices)
+std::pmr::vector<Vector2i> MapGenerator::getNeighboringIndices(const std::pmr::vector<Vector2i>& indices)
 {
     static const std::vector<Vector2i> directions = { { -1, 0}, { 1, 0}, { 0, -1}, { 0, 1}, { -1, -1}, { 1, 1}, { -1, 1}, { 1, -1} };
 
     Vector2i pos;
-    std::vector<Vector2i> neighboringIndices;
+    std::pmr::vector<Vector2i> neighboringIndices(FrameArena::resource());
     for (Vector2i index: indices)
     {
         for (Vector2i direction: directions)
@@ -208,84 +488,117 @@ std::vector<Vector2i> MapGenerator::getNeighboringIndices(std::vector<Vector2i>
     return neighboringIndices;
 }
 
-std::vector<Vector2i> MapGenerator::getNeighboringIndices(Cube cube)
+std::pmr::vector<Vector2i> MapGenerator::getNeighboringIndices(Cube cube)
 {
-    std::vector<Vector2i> indices = getCubeIndices(cube);
+    std::pmr::vector<Vector2i> indices = getCubeIndices(cube);
     return getNeighboringIndices(indices);
 }
 
-void MapGenerator::colorTiles(std::list<Vector2i> indices)
+void MapGenerator::colorTiles(const GridPath& indices, int scale)
 {
-    for (Cube& cube: grid)
-        cube.color = defaultCubeColor;
+    // a tile of a coarser map covers scale * scale tiles of this one
+    highlightedTiles.clear();
     for (Vector2i index: indices)
-        grid[twoDimToOneDimIndex(index)].color = RED;
+        for (int y = 0; y < scale; y++)
+            for (int x = 0; x < scale; x++)
+                highlightedTiles.push_back({ index.x * scale + x, index.y * scale + y });
 }
 
-std::vector<Vector3> MapGenerator::pathfindPositionsForElf(Vector3 start, Vector3 goal)
+Path MapGenerator::pathfindPositionsForElf(Vector3 start, Vector3 goal)
 {
     Vector2i startIndex = worldPositionToIndex(start);
     Vector2i goalIndex = worldPositionToIndex(goal);
 
-    std::list<Vector2i> paths = AStar::findPath(startIndex, goalIndex, elfObstacles);
-    std::vector<Vector3> positions;
+    // walled in goals would flood the whole region before failing, walk to the closest reachable cell instead
+    if (!elfComponents.isReachable(startIndex, goalIndex))
+        goalIndex = elfComponents.findNearestReachable(startIndex, goalIndex);
 
-    colorTiles(paths);
+    auto begin = std::chrono::steady_clock::now();
+    GridPath paths = AStar::findPath(startIndex, goalIndex, elfObstacles, searchOptions);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
 
-    for (Vector2i index: paths)
-        positions.push_back(indexToWorldPosition(index));
+    {
+        std::lock_guard<std::mutex> lock(pathfindingMutex);
+        pathfindingTime += elapsed;
+        pathfindingQueries++;
+        colorTiles(paths);
+    }
+
+    Path positions;
+    positions.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+        positions[i] = indexToWorldPosition(paths[i]);
 
     return positions;
 }
 
-std::vector<Vector3> MapGenerator::pathfindPositionsForTroll(Vector3 start, Vector3 goal)
+Path MapGenerator::pathfindPositionsForTroll(Vector3 start, Vector3 goal)
 {
     Vector2i startIndex = worldPositionToIndex(start);
     Vector2i goalIndex = worldPositionToIndex(goal);
 
     Vector2i startTrollIndex = { startIndex.x/2, startIndex.y/2 }; // half to account for troll obstacle map
     Vector2i goalTrollIndex = { goalIndex.x/2, goalIndex.y/2 }; // half to account for troll obstacle map
-    std::list<Vector2i> paths = AStar::findPath(startTrollIndex, goalTrollIndex, trollObstacles);
-    std::vector<Vector3> positions;
-
+    if (!trollComponents.isReachable(startTrollIndex, goalTrollIndex))
+        goalTrollIndex = trollComponents.findNearestReachable(startTrollIndex, goalTrollIndex);
+    auto begin = std::chrono::steady_clock::now();
+    GridPath paths = AStar::findPath(startTrollIndex, goalTrollIndex, trollObstacles, searchOptions);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    Path positions;
+    positions.resize(paths.size());
     Vector3 pos;
     float halfCubeSize = cubeSize.x/2;
-    for (Vector2i index: paths)
+    for (size_t i = 0; i < paths.size(); i++)
     {
-        pos = indexToWorldPosition({ index.x * 2, index.y * 2 }); // double index to get real index
-        positions.push_back({ pos.x + halfCubeSize, pos.y, pos.z + halfCubeSize }); // adjust to make pos middle of 2x2
+        pos = indexToWorldPosition({ paths[i].x * 2, paths[i].y * 2 }); // double index to get real index
+        positions[i] = { pos.x + halfCubeSize, pos.y, pos.z + halfCubeSize }; // adjust to make pos middle of 2x2
     }
 
-    std::list<Vector2i> updatedPaths;
-    Vector2i doubleIndex;
-    for (Vector2i index: paths)
     {
-        doubleIndex = { index.x * 2, index.y * 2 }; // top left
-        updatedPaths.push_back(doubleIndex);
-        updatedPaths.push_back({ doubleIndex.x + 1, doubleIndex.y + 0 }); // top right
-        updatedPaths.push_back({ doubleIndex.x + 0, doubleIndex.y + 1 }); // bottom left
-        updatedPaths.push_back({ doubleIndex.x + 1, doubleIndex.y + 1 }); // bottom right
+        std::lock_guard<std::mutex> lock(pathfindingMutex);
+        pathfindingTime += elapsed;
+        pathfindingQueries++;
+        colorTiles(paths, 2); // every troll tile covers 2x2 real tiles
     }
 
-    colorTiles(updatedPaths);
-
     return positions;
 }
 
-Cube* MapGenerator::raycastToGround()
+std::optional<Cube> MapGenerator::raycastToGround(Ray ray)
 {
-    Ray ray = CameraManager::get().getMouseRay();
-    float closestCollisionDistance = std::numeric_limits<float>::infinity();
-    Cube* nearestCube = nullptr;
+    // chunks by the distance the ray enters them, a tile can't be hit before the chunk it is in
+    std::vector<std::pair<float, MapChunk*>> hitChunks;
+    for (MapChunk& chunk: chunks)
+    {
+        RayCollision collision = GetRayCollisionBox(ray, chunk.bounds);
+        if (collision.hit)
+            hitChunks.push_back({ collision.distance, &chunk });
+    }
+    std::sort(hitChunks.begin(), hitChunks.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
 
-    for (Cube& cube: grid)
+    float closestCollisionDistance = std::numeric_limits<float>::infinity();
+    std::optional<Cube> nearestCube;
+    for (auto& [distance, chunk]: hitChunks)
     {
-        RayCollision collision = GetRayCollisionBox(ray, getCubeBoundingBox(cube));
+        if (distance > closestCollisionDistance)
+            break;
 
-        if (collision.hit && collision.distance < closestCollisionDistance)
+        for (int y = chunk->origin.y; y < chunk->origin.y + chunk->size.y; y++)
         {
-            closestCollisionDistance = collision.distance;
-            nearestCube = &cube;
+            for (int x = chunk->origin.x; x < chunk->origin.x + chunk->size.x; x++)
+            {
+                if (getTile({ x, y }).type == TILE_EMPTY)
+                    continue;
+
+                Cube cube = getTileCube({ x, y });
+                RayCollision collision = GetRayCollisionBox(ray, getCubeBoundingBox(cube));
+                if (collision.hit && collision.distance < closestCollisionDistance)
+                {
+                    closestCollisionDistance = collision.distance;
+                    nearestCube = cube;
+                }
+            }
         }
     }
 
@@ -0,0 +1,120 @@
+#include "MatchHost.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+
+MatchHost::MatchHost(size_t nrOfMatches, size_t nrOfThreads, unsigned short basePort, int tickRate)
+    : pool(nrOfThreads)
+{
+    this->tickRate = tickRate;
+
+    // matches only read the fixed timestep, no match has a mouse or keyboard of its own
+    InputManager::get().setSimulated(true);
+    InputManager::get().getSimulatedInput().frameTime = 1.f / tickRate;
+
+    matches.reserve(nrOfMatches);
+    for (size_t i = 0; i < nrOfMatches; i++)
+    {
+        Match match;
+        match.id = i;
+        match.port = basePort + i;
+        match.gameScreen = new GameScreen({ 0, 0 }, false);
+        match.networkManager = new NetworkManager(SERVER, match.port, match.gameScreen);
+        match.gameScreen->networkManager = match.networkManager;
+        matches.push_back(match);
+    }
+
+    LOG_INFO("hosting %zu matches on ports %u-%u with %zu threads at %d ticks per second",
+        nrOfMatches, (unsigned)basePort, (unsigned)(basePort + nrOfMatches - 1), pool.size(), tickRate);
+}
+
+MatchHost::~MatchHost()
+{
+    for (Match& match: matches)
+    {
+        match.networkManager->shutdown();
+        delete match.networkManager;
+        delete match.gameScreen;
+    }
+}
+
+void MatchHost::tick()
+{
+    PROFILE_ZONE("MatchHost::tick");
+    for (Match& match: matches)
+    {
+        pool.submit([&match]() {
+            PROFILE_ZONE("match");
+            FrameArena::Scope frame; // pool threads run a tick of one match at a time, the arena is theirs meanwhile
+            auto start = std::chrono::steady_clock::now();
+
+            match.networkManager->poll();
+            match.gameScreen->updateSimulation();
+
+            match.tickTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+
+    pool.wait();
+}
+
+void MatchHost::run()
+{
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+    auto nextTick = std::chrono::steady_clock::now();
+    auto lastReport = nextTick;
+
+    double worstTick = 0;
+    double totalTick = 0;
+    size_t nrOfTicks = 0;
+    size_t overruns = 0;
+
+    while (running)
+    {
+        auto start = std::chrono::steady_clock::now();
+        tick();
+        auto end = std::chrono::steady_clock::now();
+
+        double elapsed = std::chrono::duration<double>(end - start).count();
+        worstTick = std::max(worstTick, elapsed);
+        totalTick += elapsed;
+        nrOfTicks++;
+
+        nextTick += interval;
+        if (end > nextTick) // fell behind, skip ahead instead of trying to catch up with a burst of ticks
+        {
+            overruns++;
+            nextTick = end;
+        }
+
+        if (end - lastReport >= std::chrono::seconds(constants::MATCH_HOST_REPORT_INTERVAL_S))
+        {
+            report(worstTick, totalTick, nrOfTicks, overruns);
+            lastReport = end;
+            worstTick = 0;
+            totalTick = 0;
+            nrOfTicks = 0;
+            overruns = 0;
+        }
+
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void MatchHost::report(double worstTick, double totalTick, size_t nrOfTicks, size_t overruns)
+{
+    const Match* slowest = nullptr;
+    size_t nrOfPlayers = 0;
+    for (const Match& match: matches)
+    {
+        nrOfPlayers += match.gameScreen->playerManager->players.size();
+        if (!slowest || match.tickTime > slowest->tickTime)
+            slowest = &match;
+    }
+
+    LOG_INFO("match host: %zu matches, %zu players, tick avg %.2f ms, max %.2f ms, %zu overruns",
+        matches.size(), nrOfPlayers, nrOfTicks ? totalTick / nrOfTicks * 1000.0 : 0.0, worstTick * 1000.0, overruns);
+
+    if (slowest)
+        LOG_INFO("  slowest match %zu (port %u): %.2f ms last tick",
+            slowest->id, (unsigned)slowest->port, slowest->tickTime * 1000.0);
+}
@@ -0,0 +1,126 @@
+#include "NetworkConditioner.h"
+
+#include <algorithm>
+
+NetworkConditioner::NetworkConditioner()
+{
+    rng = std::mt19937(std::random_device()());
+    lastOrderedRelease = Clock::now();
+    bandwidthFreeAt = Clock::now();
+}
+
+void NetworkConditioner::configure(ConditionerSettings settings)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->settings = settings;
+}
+
+ConditionerSettings NetworkConditioner::getSettings()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+bool NetworkConditioner::isEnabled()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings.isEnabled() || !pending.empty(); // keep draining after being switched off
+}
+
+size_t NetworkConditioner::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+bool NetworkConditioner::roll(float chance)
+{
+    return chance > 0.f && std::uniform_real_distribution<float>(0.f, 1.f)(rng) < chance;
+}
+
+void NetworkConditioner::schedule(ConditionedMessage message, Clock::time_point releaseTime)
+{
+    bool ordered = message.reliability == RELIABLE_ORDERED
+        || message.reliability == RELIABLE_SEQUENCED
+        || message.reliability == UNRELIABLE_SEQUENCED;
+
+    if (ordered)
+    {
+        releaseTime = std::max(releaseTime, lastOrderedRelease); // jitter and resends must not reorder the channel
+        lastOrderedRelease = releaseTime;
+    }
+
+    pending.emplace(releaseTime, std::move(message));
+}
+
+void NetworkConditioner::send(const RakNet::BitStream* bs, size_t recipients, PacketPriority priority, PacketReliability reliability, const RakNet::AddressOrGUID systemIdentifier, bool broadcast)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    bool reliable = reliability != UNRELIABLE && reliability != UNRELIABLE_SEQUENCED;
+    size_t bytes = bs->GetNumberOfBytesUsed();
+    Clock::time_point now = Clock::now();
+
+    // serialization delay on the capped uplink comes before the propagation delay
+    Clock::time_point sentAt = now;
+    if (settings.bandwidth > 0)
+    {
+        bandwidthFreeAt = std::max(bandwidthFreeAt, now) + std::chrono::microseconds(bytes * recipients * 1000000 / settings.bandwidth);
+        sentAt = bandwidthFreeAt;
+    }
+
+    int delay = settings.latency;
+    if (settings.jitter > 0)
+        delay += std::uniform_int_distribution<int>(0, settings.jitter)(rng);
+
+    if (roll(settings.loss))
+    {
+        if (!reliable)
+        {
+            dropped++;
+            return;
+        }
+
+        // resent after roughly a round trip, RakNet doesn't go below 100 ms, and the resend can be lost too
+        int retransmissionTimeout = std::max(2 * settings.latency + settings.jitter, 100);
+        int resends = 0;
+        do
+        {
+            delay += retransmissionTimeout;
+            retransmitted++;
+        } while (roll(settings.loss) && ++resends < 10);
+    }
+
+    ConditionedMessage message = {
+        std::vector<char>(bs->GetData(), bs->GetData() + bytes),
+        priority,
+        reliability,
+        systemIdentifier,
+        broadcast
+    };
+
+    if (!reliable && roll(settings.duplication))
+    {
+        duplicated++;
+        schedule(message, sentAt + std::chrono::milliseconds(delay + settings.jitter));
+    }
+
+    schedule(std::move(message), sentAt + std::chrono::milliseconds(delay));
+}
+
+void NetworkConditioner::update(RakNet::RakPeerInterface* rakPeerInterface)
+{
+    std::vector<ConditionedMessage> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Clock::time_point now = Clock::now();
+        auto end = pending.upper_bound(now);
+        for (auto it = pending.begin(); it != end; ++it)
+            due.push_back(std::move(it->second));
+        pending.erase(pending.begin(), end);
+    }
+
+    // sent outside of the lock, RakNet may block for a moment
+    for (ConditionedMessage& message: due)
+        rakPeerInterface->Send(message.data.data(), message.data.size(), message.priority, message.reliability, 0, message.systemIdentifier, message.broadcast, 0);
+}
@@ -1,9 +1,15 @@
 #include "NetworkManager.h"
+#include "Profiler.h"
+
+#include <algorithm>
 
 NetworkManager::NetworkManager(NetworkType networkType, size_t port, GameScreen* gameScreen)
 {
     this->networkType = networkType;
     this->gameScreen = gameScreen;
+    this->startTime = std::chrono::steady_clock::now();
+    this->lastStatsSample = this->startTime;
+    this->lastStatsDump = this->startTime;
 
     rakPeerInterface = RakNet::RakPeerInterface::GetInstance();
 
@@ -24,11 +30,11 @@ NetworkManager::NetworkManager(NetworkType networkType, size_t port, GameScreen*
             socketDescriptor = RakNet::SocketDescriptor(0, "");
             rakPeerInterface->Startup(1, &socketDescriptor, 1);
 
-            printf("Connecting to server...\n");
+            LOG_INFO("Connecting to server...");
             RakNet::ConnectionAttemptResult attempt = rakPeerInterface->Connect("127.0.0.1", port, nullptr, 0);
             if (attempt != RakNet::CONNECTION_ATTEMPT_STARTED)
             {
-                printf("Failed to connect to server.\n");
+                LOG_ERROR("Failed to connect to server.");
                 running = false;
             }
             break;
@@ -40,79 +46,250 @@ unsigned char NetworkManager::getPacketIdentifier(RakNet::Packet* packet)
     if (packet == nullptr)
         return 255;
 
-    if ((unsigned char)packet->data[0] == ID_TIMESTAMP)
-        return (unsigned char)packet->data[sizeof(unsigned char) + sizeof(unsigned long)];
+    return getPacketIdentifier(packet->data);
+}
+
+unsigned char NetworkManager::getPacketIdentifier(const unsigned char* data)
+{
+    if (data[0] == ID_TIMESTAMP)
+        return data[sizeof(unsigned char) + sizeof(unsigned long)];
+
+    return data[0];
+}
 
-    return (unsigned char)packet->data[0];
+const char* NetworkManager::getPacketName(RakNet::Packet* packet)
+{
+    return getMessageName(getPacketIdentifier(packet));
 }
 
-std::string NetworkManager::getPacketName(RakNet::Packet* packet)
+const char* NetworkManager::getMessageName(unsigned char id)
 {
-    switch (getPacketIdentifier(packet))
+    switch (id)
     {
-        case ID_NEW_INCOMING_CONNECTION:    return "ID_NEW_INCOMING_CONNECTION";
-        case ID_DISCONNECTION_NOTIFICATION: return "ID_DISCONNECTION_NOTIFICATION";
-        case ID_CONNECTION_LOST:            return "ID_CONNECTION_LOST";
-        case ID_SPAWN_PLAYER:               return "ID_SPAWN_PLAYER";
-        case ID_PLAYER_RMB_REQUEST:         return "ID_PLAYER_RMB_REQUEST";
-        case ID_PLAYER_PATH_CORRECTION:     return "ID_PLAYER_PATH_CORRECTION";
-        default:                            return "UNKNOWN PACKET IDENTIFIER";
+        case ID_CONNECTION_REQUEST_ACCEPTED:    return "ID_CONNECTION_REQUEST_ACCEPTED";
+        case ID_NEW_INCOMING_CONNECTION:        return "ID_NEW_INCOMING_CONNECTION";
+        case ID_DISCONNECTION_NOTIFICATION:     return "ID_DISCONNECTION_NOTIFICATION";
+        case ID_CONNECTION_LOST:                return "ID_CONNECTION_LOST";
+        case ID_SPAWN_PLAYER:                   return "ID_SPAWN_PLAYER";
+        case ID_PLAYER_RMB_REQUEST:             return "ID_PLAYER_RMB_REQUEST";
+        case ID_PLAYER_PATH_CORRECTION:         return "ID_PLAYER_PATH_CORRECTION";
+        default:                                return "UNKNOWN PACKET IDENTIFIER";
     }
 }
 
 void NetworkManager::listen()
+{
+    PROFILE_THREAD("network");
+    while (running)
+    {
+        poll();
+
+        // conditioned messages are released from this loop, poll often enough for the delays to stay accurate
+        std::this_thread::sleep_for(std::chrono::milliseconds(conditioner.isEnabled() ? 1 : 10));
+    }
+
+    shutdown();
+}
+
+void NetworkManager::poll()
 {
     RakNet::Packet* packet = nullptr;
     unsigned char packetId;
     Task task;
 
-    while (running)
     {
+        PROFILE_ZONE("NetworkManager::messages");
         while (messageQueue.pop(task))
             task();
+    }
 
-        while (packet = rakPeerInterface->Receive())
-        {
-            printf("packet: %s\n", getPacketName(packet).c_str());
-            packetId = getPacketIdentifier(packet);
+    if (conditioner.isEnabled())
+        conditioner.update(rakPeerInterface);
+
+    while (packet = rakPeerInterface->Receive())
+    {
+        PROFILE_ZONE("NetworkManager::packet");
+        LOG_TRACE("packet: %s", getPacketName(packet));
+        countIncoming(packet);
+        packetId = getPacketIdentifier(packet);
 
-            switch (networkType)
+        switch (networkType)
+        {
+            case SERVER:
             {
-                case SERVER:
+                switch (packetId)
                 {
-                    switch (packetId)
-                    {
-                        case ID_NEW_INCOMING_CONNECTION:    handleNewIncomingConnection(packet);        break;
-                        case ID_DISCONNECTION_NOTIFICATION: printf("A client has disconnected.\n");     break;
-                        case ID_CONNECTION_LOST:            printf("A client lost the connection.\n");  break;
-                        case ID_SPAWN_PLAYER:               printf("ID_SPAWN_PLAYER.\n");               break;
-                        case ID_PLAYER_RMB_REQUEST:         handlePlayerRMBRequest(packet);             break;
-                        default: printf("Received message with identifier %d\n", packet->data[0]);      break;
-                    }
+                    case ID_NEW_INCOMING_CONNECTION:    handleNewIncomingConnection(packet);        break;
+                    case ID_DISCONNECTION_NOTIFICATION: LOG_INFO("A client has disconnected.");     break;
+                    case ID_CONNECTION_LOST:            LOG_INFO("A client lost the connection.");  break;
+                    case ID_SPAWN_PLAYER:               LOG_DEBUG("ID_SPAWN_PLAYER.");              break;
+                    case ID_PLAYER_RMB_REQUEST:         handlePlayerRMBRequest(packet);             break;
+                    default: LOG_DEBUG("Received message with identifier %d", packet->data[0]);     break;
                 }
-                case CLIENT:
+                break;
+            }
+            case CLIENT:
+            {
+                switch (packetId)
                 {
-                    switch (packetId)
-                    {
-                        case ID_CONNECTION_REQUEST_ACCEPTED:    serverGuid = packet->guid;              break;
-                        case ID_DISCONNECTION_NOTIFICATION:     printf("We have been disconnected.\n"); break;
-                        case ID_CONNECTION_LOST:                printf("Connection lost.\n");           break;
-                        case ID_SPAWN_PLAYER:                   handleSpawnPlayer(packet);              break;
-                        case ID_PLAYER_PATH_CORRECTION:         handlePlayerPathCorrection(packet);     break;
-                        default: printf("Received message with identifier %d\n", packet->data[0]);      break;
-                    }
+                    case ID_CONNECTION_REQUEST_ACCEPTED:    serverGuid = packet->guid;              break;
+                    case ID_DISCONNECTION_NOTIFICATION:     LOG_INFO("We have been disconnected."); break;
+                    case ID_CONNECTION_LOST:                LOG_INFO("Connection lost.");           break;
+                    case ID_SPAWN_PLAYER:                   handleSpawnPlayer(packet);              break;
+                    case ID_PLAYER_PATH_CORRECTION:         handlePlayerPathCorrection(packet);     break;
+                    default: LOG_DEBUG("Received message with identifier %d", packet->data[0]);     break;
                 }
+                break;
             }
-
-            rakPeerInterface->DeallocatePacket(packet);
-            packet = nullptr;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        rakPeerInterface->DeallocatePacket(packet);
+        packet = nullptr;
     }
 
+    if (std::chrono::steady_clock::now() - lastStatsSample >= std::chrono::milliseconds(constants::NETWORK_STATS_INTERVAL_MS))
+        sampleStats();
+}
+
+void NetworkManager::shutdown()
+{
     rakPeerInterface->Shutdown(300);
     RakNet::RakPeerInterface::DestroyInstance(rakPeerInterface);
+    rakPeerInterface = nullptr;
+}
+
+void NetworkManager::send(RakNet::BitStream* bs, PacketPriority priority, PacketReliability reliability, const RakNet::AddressOrGUID systemIdentifier, bool broadcast)
+{
+    uint64_t recipients = broadcast ? rakPeerInterface->NumberOfConnections() : 1;
+    MessageCounters& counters = messageCounters[getPacketIdentifier(bs->GetData())];
+    counters.messagesOut.fetch_add(recipients, std::memory_order_relaxed);
+    counters.bytesOut.fetch_add(recipients * bs->GetNumberOfBytesUsed(), std::memory_order_relaxed);
+
+    if (conditioner.isEnabled())
+        conditioner.send(bs, recipients, priority, reliability, systemIdentifier, broadcast);
+    else
+        rakPeerInterface->Send(bs, priority, reliability, 0, systemIdentifier, broadcast, 0);
+}
+
+void NetworkManager::countIncoming(RakNet::Packet* packet)
+{
+    MessageCounters& counters = messageCounters[getPacketIdentifier(packet)];
+    counters.messagesIn.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesIn.fetch_add(packet->length, std::memory_order_relaxed);
+}
+
+// Network thread
+void NetworkManager::sampleStats()
+{
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastStatsSample).count();
+    lastStatsSample = now;
+
+    NetworkStats sample;
+    sample.uptime = std::chrono::duration<double>(now - startTime).count();
+
+    RakNet::SystemAddress addresses[constants::MAX_PLAYERS];
+    unsigned short nrOfConnections = constants::MAX_PLAYERS;
+    rakPeerInterface->GetConnectionList(addresses, &nrOfConnections);
+    for (unsigned short i = 0; i < nrOfConnections; i++)
+    {
+        RakNet::RakNetStatistics rns;
+        if (!rakPeerInterface->GetStatistics(addresses[i], &rns))
+            continue;
+
+        ConnectionStats connection;
+        connection.address = addresses[i].ToString(true);
+        connection.lastPing = rakPeerInterface->GetLastPing(addresses[i]);
+        connection.averagePing = rakPeerInterface->GetAveragePing(addresses[i]);
+        connection.lowestPing = rakPeerInterface->GetLowestPing(addresses[i]);
+        connection.bytesSentPerSecond = rns.valueOverLastSecond[RakNet::ACTUAL_BYTES_SENT];
+        connection.bytesReceivedPerSecond = rns.valueOverLastSecond[RakNet::ACTUAL_BYTES_RECEIVED];
+        connection.bytesSentTotal = rns.runningTotal[RakNet::ACTUAL_BYTES_SENT];
+        connection.bytesReceivedTotal = rns.runningTotal[RakNet::ACTUAL_BYTES_RECEIVED];
+        connection.bytesResentPerSecond = rns.valueOverLastSecond[RakNet::USER_MESSAGE_BYTES_RESENT];
+        connection.bytesResentTotal = rns.runningTotal[RakNet::USER_MESSAGE_BYTES_RESENT];
+        connection.messagesInResendBuffer = rns.messagesInResendBuffer;
+        connection.packetLoss = rns.packetlossLastSecond;
+        sample.connections.push_back(connection);
+    }
+
+    for (size_t id = 0; id < messageCounters.size(); id++)
+    {
+        MessageCounters& counters = messageCounters[id];
+        MessageStats message;
+        message.id = id;
+        message.name = getMessageName(id);
+        message.messagesIn = counters.messagesIn.load(std::memory_order_relaxed);
+        message.bytesIn = counters.bytesIn.load(std::memory_order_relaxed);
+        message.messagesOut = counters.messagesOut.load(std::memory_order_relaxed);
+        message.bytesOut = counters.bytesOut.load(std::memory_order_relaxed);
+
+        MessageStats& previous = previousMessageStats[id];
+        message.messagesInPerSecond = (message.messagesIn - previous.messagesIn) / elapsed;
+        message.messagesOutPerSecond = (message.messagesOut - previous.messagesOut) / elapsed;
+        message.bytesInPerSecond = (message.bytesIn - previous.bytesIn) / elapsed;
+        message.bytesOutPerSecond = (message.bytesOut - previous.bytesOut) / elapsed;
+        previous = message;
+
+        if (message.messagesIn || message.messagesOut)
+            sample.messages.push_back(message);
+    }
+
+    sample.networkQueueDepth = messageQueue.size();
+    sample.networkQueueHighWater = messageQueue.takeHighWaterMark();
+    sample.gameQueueDepth = gameScreen->messageQueue.size();
+    sample.gameQueueHighWater = gameScreen->messageQueue.takeHighWaterMark();
+
+    {
+        WorldSnapshotBuffer::Reader snapshot = gameScreen->snapshots.read();
+        sample.tick = snapshot->tick;
+        sample.nrOfPlayers = snapshot->players.size();
+        sample.nrOfBuildings = snapshot->nrOfBuildings;
+    }
+
+    sample.conditionerEnabled = conditioner.getSettings().isEnabled();
+    sample.conditionerPending = conditioner.getPendingCount();
+    sample.conditionerDropped = conditioner.dropped.load();
+    sample.conditionerDuplicated = conditioner.duplicated.load();
+    sample.conditionerRetransmitted = conditioner.retransmitted.load();
+
+    if (constants::NETWORK_STATS_DUMP_INTERVAL_S > 0
+    &&  now - lastStatsDump >= std::chrono::seconds(constants::NETWORK_STATS_DUMP_INTERVAL_S))
+    {
+        lastStatsDump = now;
+        dumpStats(sample);
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats = sample;
+}
+
+void NetworkManager::dumpStats(const NetworkStats& stats)
+{
+    LOG_INFO("network stats at %.0fs: network queue %zu (max %zu), game queue %zu (max %zu), tick %" PRIu64 ", %zu players, %zu buildings",
+        stats.uptime, stats.networkQueueDepth, stats.networkQueueHighWater, stats.gameQueueDepth, stats.gameQueueHighWater,
+        stats.tick, stats.nrOfPlayers, stats.nrOfBuildings);
+
+    if (stats.conditionerEnabled)
+        LOG_INFO("  conditioner: %zu pending, %" PRIu64 " dropped, %" PRIu64 " duplicated, %" PRIu64 " retransmitted",
+            stats.conditionerPending, stats.conditionerDropped, stats.conditionerDuplicated, stats.conditionerRetransmitted);
+
+    for (const ConnectionStats& connection: stats.connections)
+        LOG_INFO("  %s: rtt %d ms (avg %d, min %d), out %" PRIu64 " B/s, in %" PRIu64 " B/s, resent %" PRIu64 " B total, %u awaiting resend, loss %.1f%%",
+            connection.address.c_str(), connection.lastPing, connection.averagePing, connection.lowestPing,
+            connection.bytesSentPerSecond, connection.bytesReceivedPerSecond, connection.bytesResentTotal,
+            connection.messagesInResendBuffer, connection.packetLoss * 100.f);
+
+    for (const MessageStats& message: stats.messages)
+        LOG_INFO("  %s (%d): in %" PRIu64 " msgs / %" PRIu64 " B (%.1f/s), out %" PRIu64 " msgs / %" PRIu64 " B (%.1f/s)",
+            message.name.c_str(), message.id, message.messagesIn, message.bytesIn, message.messagesInPerSecond,
+            message.messagesOut, message.bytesOut, message.messagesOutPerSecond);
+}
+
+NetworkStats NetworkManager::getStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
 }
 
 // Server
@@ -135,22 +312,41 @@ void NetworkManager::handleNewIncomingConnection(RakNet::Packet* packet)
     // broadcast new player to all clients
     RakNet::BitStream bsOut;
     spawnPlayer.serialize(true, &bsOut);
-    rakPeerInterface->Send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, 0, RakNet::UNASSIGNED_SYSTEM_ADDRESS, true, 0);
+    send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, RakNet::UNASSIGNED_SYSTEM_ADDRESS, true);
+
+    // send all current players to the new client, as of the last tick plus those the game thread hasn't added yet
+    WorldSnapshotBuffer::Reader snapshot = gameScreen->snapshots.read();
+    auto isPublished = [&snapshot](const SpawnPlayerRequest& spawn) {
+        for (const PlayerSnapshot& player: snapshot->players)
+            if (player.networkId == spawn.networkId)
+                return true;
+        return false;
+    };
+    unpublishedSpawns.erase(std::remove_if(unpublishedSpawns.begin(), unpublishedSpawns.end(), isPublished), unpublishedSpawns.end());
 
-    // send all current players to the new client
-    for (Player* player: gameScreen->playerManager->players) // WARNING: subject to race-condition
+    SpawnPlayerRequest newSpawn = spawnPlayer;
+    for (const PlayerSnapshot& player: snapshot->players)
     {
         bsOut.Reset();
         spawnPlayer = {
             .packetType = packetType,
-            .position   = player->getPosition(),
-            .type       = player->playerType,
-            .networkId  = player->GetNetworkID(),
+            .position   = player.position,
+            .type       = player.type,
+            .networkId  = player.networkId,
             .ownerGuid  = 0,
         };
         spawnPlayer.serialize(true, &bsOut);
-        rakPeerInterface->Send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, 0, packet->guid, false, 0);
+        send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, packet->guid, false);
+    }
+
+    for (SpawnPlayerRequest unpublished: unpublishedSpawns)
+    {
+        bsOut.Reset();
+        unpublished.ownerGuid = 0;
+        unpublished.serialize(true, &bsOut);
+        send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, packet->guid, false);
     }
+    unpublishedSpawns.push_back(newSpawn);
 
     // finally, add the new player to the game
     this->gameScreen->messageQueue.push([this, newPlayer]() {
@@ -185,31 +381,31 @@ void NetworkManager::handlePlayerPathCorrection(RakNet::Packet* packet)
     PlayerPathCorrection playerPathCorrection;
     playerPathCorrection.serialize(false, &bsIn);
 
-    gameScreen->messageQueue.push([this, playerPathCorrection]() {
+    gameScreen->messageQueue.push([this, playerPathCorrection]() mutable {
         Player* player = this->gameScreen->playerManager->getPlayerWithNetworkID(playerPathCorrection.networkId);
         if (!player)
         {
-            printf("Unexpected error occured; player with networkId (%u) could not be found\n", playerPathCorrection.networkId);
+            LOG_ERROR("Unexpected error occured; player with networkId (%" PRIu64 ") could not be found", playerPathCorrection.networkId);
             return;
         }
 
-        player->correctPath(playerPathCorrection.path);
+        player->correctPath(std::move(playerPathCorrection.path));
     });
 }
 
 // Server
-void NetworkManager::sendPlayerPathCorrection(Player* player, std::vector<Vector3> path)
+void NetworkManager::sendPlayerPathCorrection(Player* player, Path path)
 {
     PlayerPathCorrection playerPathCorrection = {
         .packetType = (RakNet::MessageID)ID_PLAYER_PATH_CORRECTION,
         .networkId  = player->GetNetworkID(),
         .nrOfPaths  = path.size(),
-        .path       = path
+        .path       = std::move(path)
     };
 
     RakNet::BitStream bsOut;
     playerPathCorrection.serialize(true, &bsOut);
-    rakPeerInterface->Send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, 0, RakNet::UNASSIGNED_SYSTEM_ADDRESS, true, 0);
+    send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, RakNet::UNASSIGNED_SYSTEM_ADDRESS, true);
 }
 
 // Server
@@ -220,18 +416,19 @@ void NetworkManager::handlePlayerRMBRequest(RakNet::Packet* packet)
     // IMPROVEMENT: make sure this request is coming from a client that owns the player
     PlayerRMBRequest playerRMB;
     playerRMB.serialize(false, &bsIn);
-    // std::this_thread::sleep_for(std::chrono::milliseconds(400)); // artificial latency
     this->gameScreen->messageQueue.push([this, playerRMB]() {
         Player* player = this->gameScreen->playerManager->getPlayerWithNetworkID(playerRMB.networkId);
         if (!player)
         {
-            printf("Unexpected error occured; player with networkId (%u) could not be found\n", playerRMB.networkId);
+            LOG_ERROR("Unexpected error occured; player with networkId (%" PRIu64 ") could not be found", playerRMB.networkId);
             return;
         }
 
         // update server state and broadcast path to all clients
-        std::vector<Vector3> path = this->gameScreen->playerManager->pathfindPlayerToPosition(player, playerRMB.position);
-        this->messageQueue.push([this, player, path]() { this->sendPlayerPathCorrection(player, path); });
+        this->gameScreen->playerManager->requestPath(player, playerRMB.position, [this, player](const Path& path) {
+            // the message is the second owner, the player keeps walking its own copy
+            this->messageQueue.push([this, player, path]() mutable { this->sendPlayerPathCorrection(player, std::move(path)); });
+        });
     });
 }
 
@@ -246,5 +443,5 @@ void NetworkManager::sendPlayerRMBRequest(Player* player, Vector3 position)
 
     RakNet::BitStream bsOut;
     playerRMB.serialize(true, &bsOut);
-    rakPeerInterface->Send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, 0, serverGuid, false, 0);
+    send(&bsOut, HIGH_PRIORITY, RELIABLE_ORDERED, serverGuid, false);
 }
\ No newline at end of file
@@ -1,120 +1,366 @@
 #include "PathFinding.h"
+#include "FrameArena.h"
+#include "Profiler.h"
 
-#include "time.h" // time_t
 #include <iomanip>
 #include <iostream>
 #include <limits>
 
 namespace AStar
 {
-    double weightedConvexUpwardParabola(double g, double h)
+    static const int directions[8][2] = {
+        {-1,  0},
+        { 1,  0},
+        { 0, -1},
+        { 0,  1},
+
+        {-1, -1}, // diagonals
+        { 1,  1}, // diagonals
+        {-1,  1}, // diagonals
+        { 1, -1}, // diagonals
+    };
+
+    float octileDistance(Vector2i from, Vector2i to)
+    {
+        // admissible and consistent for 8-connected grids where diagonal steps cost sqrt(2)
+        int dx = std::abs(from.x - to.x);
+        int dy = std::abs(from.y - to.y);
+        return float(dx + dy) + (DIAGONAL_COST - 2.f) * float(std::min(dx, dy));
+    }
+
+    double weightedConvexUpwardParabola(double g, double h, double weight)
     {
-        double weight = 2.f;
         double numerator = g + h + sqrt(pow(g + h, 2) + 4 * weight * (weight - 1) * pow(h, 2));
         double denominator = 2 * weight;
         return numerator / denominator;
     }
 
-    double weightedConvexDownwardParabola(double g, double h)
+    double weightedConvexDownwardParabola(double g, double h, double weight)
     {
-        double weight = 2.f;
         double numerator = g + (2 * weight - 1) * h + sqrt(pow(g - h, 2) + 4 * weight * g * h);
         double denominator = 2 * weight;
         return numerator / denominator;
     }
 
-    std::list<Vector2i> backtrack(std::unordered_map<Vector2i, Node, HashVector2i>& nodes, Node& start, Node node)
+    double priority(double g, double h, const SearchOptions& options)
+    {
+        switch (options.variant)
+        {
+            case SEARCH_ASTAR:
+            case SEARCH_BIDIRECTIONAL:      return g + h;
+            case SEARCH_WEIGHTED:           return g + options.weight * h;
+            case SEARCH_CONVEX_UPWARD:      return weightedConvexUpwardParabola(g, h, options.weight);
+            case SEARCH_CONVEX_DOWNWARD:    return weightedConvexDownwardParabola(g, h, options.weight);
+        }
+
+        return g + h;
+    }
+
+    GridPath backtrack(std::pmr::unordered_map<Vector2i, Node, HashVector2i>& nodes, Node& start, Node node)
     {
-        std::list<Vector2i> path;
+        GridPath path(FrameArena::resource());
+        path.reserveFront(size_t(node.g - start.g) + 1); // every step costs at least 1, the path can't be longer
         while (node != start)
         {
-            path.push_front(node.pos);
+            path.pushFront(node.pos);
             node = nodes[node.parentPos];
         }
         return path;
     }
 
-    std::list<Vector2i> findPath(Vector2i start, Vector2i goal, const std::vector<std::vector<bool>>& obstacles)
+    bool hasLineOfSight(Vector2i from, Vector2i to, const std::vector<std::vector<bool>>& obstacles)
+    {
+        // bresenham, diagonal steps also require both orthogonal cells to be free so corners can't be cut
+        int dx = std::abs(to.x - from.x);
+        int dy = -std::abs(to.y - from.y);
+        int sx = from.x < to.x ? 1 : -1;
+        int sy = from.y < to.y ? 1 : -1;
+        int error = dx + dy;
+        int doubleError;
+        bool stepX, stepY;
+        Vector2i pos = from;
+
+        while (true)
+        {
+            if (obstacles[pos.y][pos.x])
+                return false;
+
+            if (pos == to)
+                return true;
+
+            doubleError = 2 * error;
+            stepX = doubleError >= dy;
+            stepY = doubleError <= dx;
+            if (stepX && stepY && (obstacles[pos.y][pos.x + sx] || obstacles[pos.y + sy][pos.x]))
+                return false;
+
+            if (stepX) { error += dy; pos.x += sx; }
+            if (stepY) { error += dx; pos.y += sy; }
+        }
+    }
+
+    GridPath smoothPath(Vector2i start, const GridPath& path, const std::vector<std::vector<bool>>& obstacles)
+    {
+        // string pulling, skip every waypoint that is visible from the last kept corner
+        if (path.size() < 2)
+            return GridPath(path, FrameArena::resource());
+
+        GridPath smoothed(FrameArena::resource());
+        Vector2i anchor = start;
+        Vector2i previous = start;
+        for (const Vector2i& pos: path)
+        {
+            if (!(previous == anchor) && !hasLineOfSight(anchor, pos, obstacles))
+            {
+                smoothed.pushBack(previous);
+                anchor = previous;
+            }
+            previous = pos;
+        }
+        smoothed.pushBack(path.back());
+
+        return smoothed;
+    }
+
+    GridPath findPath(
+        Vector2i start,
+        Vector2i goal,
+        const std::vector<std::vector<bool>>& obstacles,
+        const SearchOptions& options,
+        SearchStats* stats)
     {
-        clock_t start_t = clock();      // for debugging purposes
-        int allocations = 0;            // for debugging purposes
-        bool printDebugInfo = false;    // for debugging purposes
+        PROFILE_ZONE("AStar::findPath");
+        SearchStats localStats;
+        SearchStats& searchStats = stats ? *stats : localStats;
+        searchStats = SearchStats();
+
+        GridPath path = options.variant == SEARCH_BIDIRECTIONAL
+            ? findPathBidirectional(start, goal, obstacles, options, searchStats)
+            : findPathUnidirectional(start, goal, obstacles, options, searchStats);
 
-        int count = 0;
+        if (options.smoothPath)
+            return smoothPath(start, path, obstacles);
+
+        return path;
+    }
+
+    GridPath findPathUnidirectional(
+        Vector2i start,
+        Vector2i goal,
+        const std::vector<std::vector<bool>>& obstacles,
+        const SearchOptions& options,
+        SearchStats& stats)
+    {
         int maxY = obstacles.size();
         int maxX = obstacles[0].size();
         Node current, neighbor;
         Node startNode = Node(start);
         Node goalNode = Node(goal);
-        Vector2i neighborPositions[8] = { { 0 }, { 0 }, { 0 }, { 0 }, { 0 }, { 0 }, { 0 }, { 0 } };
-        static const int directions[8][2] = {
-            {-1,  0},
-            { 1,  0},
-            { 0, -1},
-            { 0,  1},
-
-            {-1, -1}, // diagonals
-            { 1,  1}, // diagonals
-            {-1,  1}, // diagonals
-            { 1, -1}, // diagonals
-        };
+        Vector2i pos;
+        float g;
 
-        std::priority_queue<Node, std::vector<Node>, CompareNode> notVisitedHeap;
-        std::unordered_map<Vector2i, Node, HashVector2i> notVisitedMap;
-        std::unordered_map<Vector2i, Node, HashVector2i> visited;
+        startNode.h = octileDistance(start, goal);
+        startNode.f = priority(startNode.g, startNode.h, options);
+        Node closestNode = startNode; // used as the partial path target when the budget runs out
 
+        // every search allocates per discovered node, from the frame arena when it runs inside a tick
+        std::pmr::memory_resource* memory = FrameArena::resource();
+        std::priority_queue<Node, std::pmr::vector<Node>, CompareNode> notVisitedHeap{ CompareNode(), std::pmr::vector<Node>(memory) };
+        std::pmr::unordered_map<Vector2i, Node, HashVector2i> nodes(memory);  // best known node for every discovered position
+        std::pmr::unordered_set<Vector2i, HashVector2i> visited(memory);
+
+        nodes[start] = startNode;
         notVisitedHeap.push(startNode);
         while (!notVisitedHeap.empty())
         {
             current = notVisitedHeap.top();
             notVisitedHeap.pop();
 
-            visited[current.pos] = current;
+            if (!visited.insert(current.pos).second) // stale duplicate, a cheaper copy was already expanded
+                continue;
+
+            stats.expansions++;
 
             if (current == goalNode)
             {
-                if (printDebugInfo)
-                    printf("time, allocations, visited: %f, %d, %d\n", double(clock()-start_t)/CLOCKS_PER_SEC, allocations, visited.size());
-
-                return backtrack(visited, startNode, current);
+                stats.found = true;
+                return backtrack(nodes, startNode, current);
             }
 
-            for (int i = 0; i < 8; ++i) // calculate new positions
+            if (current.h < closestNode.h)
+                closestNode = current;
+
+            if (options.maxExpansions > 0 && stats.expansions >= options.maxExpansions)
             {
-                neighborPositions[i].x = current.pos.x + directions[i][0];
-                neighborPositions[i].y = current.pos.y + directions[i][1];
+                stats.partial = true;
+                return backtrack(nodes, startNode, closestNode);
             }
 
-            count = -1;
-            for (Vector2i& pos: neighborPositions)
+            for (int i = 0; i < 8; ++i)
             {
-                count++;
+                pos = { current.pos.x + directions[i][0], current.pos.y + directions[i][1] };
+
                 if (pos.x < 0 || pos.x >= maxX || pos.y < 0 || pos.y >= maxY    // out of bounds
-                    || visited.find(pos) != visited.end()                       // already visited
-                    || notVisitedMap.find(pos) != notVisitedMap.end()           // already in queue
-                    || obstacles[pos.y][pos.x])                                 // is not traversable
+                    || obstacles[pos.y][pos.x]                                  // is not traversable
+                    || visited.find(pos) != visited.end())                      // already visited
+                    continue;
+
+                g = current.g + (i < 4 ? 1.f : DIAGONAL_COST);
+
+                auto it = nodes.find(pos);
+                if (it != nodes.end() && it->second.g <= g) // already queued with a cheaper or equal cost
                     continue;
 
                 neighbor.pos = pos;
                 neighbor.parentPos = current.pos;
+                neighbor.g = g;
+                neighbor.h = octileDistance(pos, goal);
+                neighbor.f = priority(neighbor.g, neighbor.h, options);
 
-                neighbor.g = current.g + 1;             // increase cost by one since its one step away from current
-                neighbor.h = (                          // euclidian distance, skip sqrtf() since it doesn't actually change anything (I believe)
-                    (pos.x - goal.x) * (pos.x - goal.x)
-                  + (pos.y - goal.y) * (pos.y - goal.y)
-                );
-                // neighbor.h = sqrtf((pos.x - goal.x) * (pos.x - goal.x) + (pos.y - goal.y) * (pos.y - goal.y));
+                nodes[neighbor.pos] = neighbor;
+                notVisitedHeap.push(neighbor);
+            }
+        }
 
-                neighbor.f = neighbor.g + neighbor.h;   // this ensures shortest path is found
+        LOG_DEBUG("no path from %d, %d to %d, %d", start.x, start.y, goal.x, goal.y);
+        return GridPath(FrameArena::resource());
+    }
 
-                notVisitedMap[neighbor.pos] = neighbor;
-                notVisitedHeap.push(neighbor);
+    GridPath findPathBidirectional(
+        Vector2i start,
+        Vector2i goal,
+        const std::vector<std::vector<bool>>& obstacles,
+        const SearchOptions& options,
+        SearchStats& stats)
+    {
+        struct Frontier
+        {
+            std::priority_queue<Node, std::pmr::vector<Node>, CompareNode> heap;
+            std::pmr::unordered_map<Vector2i, Node, HashVector2i> nodes;
+            std::pmr::unordered_set<Vector2i, HashVector2i> visited;
+            Vector2i target;
 
-                if (printDebugInfo) allocations++;
+            Frontier(std::pmr::memory_resource* memory)
+                : heap(CompareNode(), std::pmr::vector<Node>(memory)), nodes(memory), visited(memory) {}
+
+            // drop duplicates that were superseded by a cheaper copy, returns the lowest f left in the heap
+            float topF()
+            {
+                while (!heap.empty() && visited.find(heap.top().pos) != visited.end())
+                    heap.pop();
+                return heap.empty() ? std::numeric_limits<float>::infinity() : heap.top().f;
             }
+        };
+
+        int maxY = obstacles.size();
+        int maxX = obstacles[0].size();
+        Node startNode = Node(start);
+        Node goalNode = Node(goal);
+        startNode.h = goalNode.h = octileDistance(start, goal);
+        startNode.f = goalNode.f = startNode.h;
+
+        std::pmr::memory_resource* memory = FrameArena::resource();
+        Frontier forward(memory), backward(memory);
+        forward.target = goal;
+        backward.target = start;
+        forward.nodes[start] = startNode;
+        forward.heap.push(startNode);
+        backward.nodes[goal] = goalNode;
+        backward.heap.push(goalNode);
+
+        Node closestNode = startNode; // closest forward node to the goal, used for partial paths
+        float bestCost = std::numeric_limits<float>::infinity();
+        Vector2i meetingPos = start;
+        bool met = false;
+        Node current, neighbor;
+        Vector2i pos;
+        float g;
+
+        if (start == goal)
+        {
+            stats.found = true;
+            return GridPath(FrameArena::resource());
         }
 
-        printf("no path?\n");
-        return std::list<Vector2i>();
+        while (true)
+        {
+            float forwardF = forward.topF();
+            float backwardF = backward.topF();
+            if (forward.heap.empty() || backward.heap.empty() || std::max(forwardF, backwardF) >= bestCost)
+                break;
+
+            // expand the side with the smaller frontier, keeps the two searches balanced
+            bool isForward = forward.heap.size() <= backward.heap.size();
+            Frontier& frontier = isForward ? forward : backward;
+            Frontier& other = isForward ? backward : forward;
+
+            current = frontier.heap.top();
+            frontier.heap.pop();
+            frontier.visited.insert(current.pos);
+            stats.expansions++;
+
+            if (isForward && current.h < closestNode.h)
+                closestNode = current;
+
+            if (options.maxExpansions > 0 && stats.expansions >= options.maxExpansions)
+            {
+                stats.partial = true;
+                if (!met)
+                    return backtrack(forward.nodes, startNode, closestNode);
+                break; // the frontiers touched already, settle for the best meeting point so far
+            }
+
+            for (int i = 0; i < 8; ++i)
+            {
+                pos = { current.pos.x + directions[i][0], current.pos.y + directions[i][1] };
+
+                if (pos.x < 0 || pos.x >= maxX || pos.y < 0 || pos.y >= maxY    // out of bounds
+                    || obstacles[pos.y][pos.x]                                  // is not traversable
+                    || frontier.visited.find(pos) != frontier.visited.end())    // already visited
+                    continue;
+
+                g = current.g + (i < 4 ? 1.f : DIAGONAL_COST);
+
+                auto it = frontier.nodes.find(pos);
+                if (it != frontier.nodes.end() && it->second.g <= g) // already queued with a cheaper or equal cost
+                    continue;
+
+                neighbor.pos = pos;
+                neighbor.parentPos = current.pos;
+                neighbor.g = g;
+                neighbor.h = octileDistance(pos, frontier.target);
+                neighbor.f = neighbor.g + neighbor.h;
+
+                frontier.nodes[neighbor.pos] = neighbor;
+                frontier.heap.push(neighbor);
+
+                auto otherIt = other.nodes.find(pos);
+                if (otherIt != other.nodes.end() && g + otherIt->second.g < bestCost) // frontiers touch here
+                {
+                    bestCost = g + otherIt->second.g;
+                    meetingPos = pos;
+                    met = true;
+                }
+            }
+        }
+
+        if (!met)
+        {
+            LOG_DEBUG("no path from %d, %d to %d, %d", start.x, start.y, goal.x, goal.y);
+            return GridPath(FrameArena::resource());
+        }
+
+        stats.found = true;
+
+        // forward half runs from start to the meeting point, backward half follows parents towards the goal
+        GridPath path = backtrack(forward.nodes, startNode, forward.nodes[meetingPos]);
+        pos = meetingPos;
+        while (!(pos == goal))
+        {
+            pos = backward.nodes[pos].parentPos;
+            path.pushBack(pos);
+        }
+
+        return path;
     }
 }
@@ -11,33 +11,35 @@ Player::Player(Vector3 position, PlayerType playerType)
         case PLAYER_ELF:
             this->capsule = Capsule(2.f, 8.f);
             this->setDefaultColor(BLUE);
-            this->originalActionId = "elf";
+            this->originalActionId = ActionsManager::get().getId("elf");
             break;
 
         case PLAYER_TROLL:
             this->capsule = Capsule(3.f, 12.f);
             this->setDefaultColor(RED);
-            this->originalActionId = "troll";
+            this->originalActionId = ActionsManager::get().getId("troll");
             break;
     }
 
     setPosition(position);
     actionId = this->originalActionId;
+    previousActionId = this->originalActionId;
 }
 
 Player::~Player() {}
 
-void Player::draw()
+void Player::draw(InstancedRenderer& renderer)
 {
-    Entity::draw();
+    Entity::draw(renderer);
 }
 
 std::vector<ActionNode> Player::getActions(int nrOfButtons)
 {
-    std::vector<ActionNode> children = ActionsManager::get().getActionChildren(actionId);
+    ActionsManager& actionsManager = ActionsManager::get();
+    std::vector<ActionNode> children = actionsManager.getActionChildren(actionId);
 
-    ActionNode fillerButton = ActionNode("filler", "Filler", "filler", {});
-    ActionNode backButton = ActionNode("back", "Back", "back", {});
+    const ActionNode& fillerButton = actionsManager.getNode(FILLER_ACTION);
+    const ActionNode& backButton = actionsManager.getNode(BACK_ACTION);
 
     int nrOfFillerButtons = nrOfButtons - children.size();
     for (int i = 0; i < nrOfFillerButtons - 1; i++)
@@ -50,23 +52,24 @@ std::vector<ActionNode> Player::getActions(int nrOfButtons)
         node.promotable = true;
         if (node.promotable)
         {
-            if (node.id == "filler")
+            ActionId id = node.id;
+            if (node.type == ACTION_FILLER)
                 node.callback = []() {};
-            else if (node.action == "back")
+            else if (node.type == ACTION_BACK)
                 node.callback = [this]() { this->actionId = this->previousActionId; };
-            else if (node.action == "build")
+            else if (node.type == ACTION_BUILD)
             {
-                if (node.id == "castle0")       node.callback = [this] { this->buildingManager->createNewGhostBuilding(CASTLE, this); };
-                else if (node.id == "rock0")    node.callback = [this] { this->buildingManager->createNewGhostBuilding(ROCK, this); };
-                else if (node.id == "hall0")    node.callback = [this] { this->buildingManager->createNewGhostBuilding(HALL, this); };
-                else if (node.id == "shop0")    node.callback = [this] { this->buildingManager->createNewGhostBuilding(SHOP, this); };
+                if (node.key == "castle0")      node.callback = [this] { this->buildingManager->createNewGhostBuilding(CASTLE, this); };
+                else if (node.key == "rock0")   node.callback = [this] { this->buildingManager->createNewGhostBuilding(ROCK, this); };
+                else if (node.key == "hall0")   node.callback = [this] { this->buildingManager->createNewGhostBuilding(HALL, this); };
+                else if (node.key == "shop0")   node.callback = [this] { this->buildingManager->createNewGhostBuilding(SHOP, this); };
             }
-            else if (node.id == "blink")
-                node.callback = []() { printf("Blink is not implemented\n"); };
-            else if (node.action == "promote")
-                node.callback = [this, node]() {
+            else if (node.type == ACTION_SPELL)
+                node.callback = []() { LOG_WARNING("spells are not implemented"); };
+            else if (node.type == ACTION_PROMOTE)
+                node.callback = [this, id]() {
                     this->previousActionId = this->actionId;
-                    this->actionId = node.id;
+                    this->actionId = id;
                 };
         }
     }
@@ -1,11 +1,18 @@
 #include "PlayerManager.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
 
-PlayerManager::PlayerManager(BuildingManager* buildingManager, MapGenerator* mapGenerator)
+PlayerManager::PlayerManager(BuildingManager* buildingManager, MapGenerator* mapGenerator, CameraManager* cameraManager)
+    : screenGrid(constants::SELECTION_GRID_CELL_SIZE)
 {
     this->buildingManager = buildingManager;
     this->mapGenerator = mapGenerator;
+    this->cameraManager = cameraManager;
 
     selectedPlayer = nullptr;
+    clientPlayer = nullptr;
+    screenGridDirty = true;
     players.reserve(constants::MAX_PLAYERS);
 }
 
@@ -15,34 +22,50 @@ PlayerManager::~PlayerManager()
         delete player;
 }
 
-void PlayerManager::draw()
+DrawCounts PlayerManager::draw(const Frustum& frustum, InstancedRenderer& renderer)
 {
+    DrawCounts counts;
     for (Player* player: players)
-        player->draw();
+    {
+        if (mapGenerator->isVisible(frustum, getCapsuleBoundingBox(player->capsule)))
+        {
+            player->draw(renderer);
+            counts.submitted++;
+            continue;
+        }
+
+        counts.culled++;
+        if (player->state == RUNNING) // the target marker may still be in view
+            drawCylinder(player->targetMarker);
+    }
+
+    return counts;
 }
 
 void PlayerManager::update()
 {
-    for (Player* player: players)
-        player->update();
+    resolvePathRequests();
 
-    Building* building = buildingManager->buildQueueFront();
-    if (building) // something is getting built
+    JobSystem::get().parallelFor(players.size(), constants::JOB_PLAYERS_PER_JOB, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            players[i]->update();
+    });
+
+    for (Player* player: players)
     {
-        Player* player = building->owner;
-        if (player->reachedDestination)
-        {
-            player->reachedDestination = false;
+        if (!player->reachedDestination || !buildingManager->buildQueueFront(player)) // nothing to build right here
+            continue;
+
+        player->reachedDestination = false;
 
-            Building* building = buildingManager->yieldBuildQueue();
-            mapGenerator->addObstacle(building->cube);
+        Building* building = buildingManager->yieldBuildQueue(player);
+        mapGenerator->addObstacle(building->cube);
 
-            building = buildingManager->buildQueueFront();
-            if (building) // if more in queue, walk to the next target
-            {
-                Vector3 pos = calculateTargetPositionToCubeFromPlayer(player, building->cube);
-                pathfindPlayerToPosition(player, pos);
-            }
+        building = buildingManager->buildQueueFront(player);
+        if (building) // if more in queue, walk to the next target
+        {
+            Vector3 pos = calculateTargetPositionToCubeFromPlayer(player, building->cube);
+            requestPath(player, pos);
         }
     }
 }
@@ -55,25 +78,29 @@ void PlayerManager::addPlayer(Player* player)
 
 void PlayerManager::select(Player* player)
 {
-    selectedPlayer = player;
+    if (!selection.add(player))
+        return;
+
     player->select();
+    if (!selectedPlayer)
+        selectedPlayer = player;
 }
 
 void PlayerManager::deselect()
 {
-    if (!selectedPlayer)
-        return;
+    for (Player* player: selection.getMembers())
+        player->deselect();
 
-    selectedPlayer->deselect();
+    selection.clear();
     selectedPlayer = nullptr;
 }
 
 Vector3 PlayerManager::calculateTargetPositionToCubeFromPlayer(Player* player, Cube cube)
 {
-    std::vector<Vector2i> indices = mapGenerator->getNeighboringIndices(cube);
+    std::pmr::vector<Vector2i> indices = mapGenerator->getNeighboringIndices(cube);
     Vector3 entityPosition = player->getPosition();
 
-    std::vector<Vector3> positions;
+    std::pmr::vector<Vector3> positions(FrameArena::resource());
     Vector3 position;
     for (Vector2i index: indices)
     {
@@ -86,47 +113,131 @@ Vector3 PlayerManager::calculateTargetPositionToCubeFromPlayer(Player* player, C
 
     if (positions.empty())
     {
-        printf("Found no valid positions, should probably do something about this later\n"); // TODO: later
+        LOG_WARNING("Found no valid positions, should probably do something about this later"); // TODO: later
         return Vector3Zero();
     }
 
     return positions[0]; // just grab the first one, don't care which one right now
 }
 
-bool PlayerManager::checkCollisionCapsulePoint(Capsule capsule, Vector2 point)
+void PlayerManager::updateScreenCapsules()
 {
-    CameraManager& cameraManager = CameraManager::get();
+    PROFILE_ZONE("PlayerManager::updateScreenCapsules");
+    screenCapsules.resize(players.size());
+    for (size_t i = 0; i < players.size(); i++)
+    {
+        Capsule& capsule = players[i]->capsule;
+        screenCapsules[i].bottom = cameraManager->convertSphereToCircle(capsule.startPos, capsule.radius);
+        screenCapsules[i].top = cameraManager->convertSphereToCircle(capsule.endPos, capsule.radius);
+    }
+
+    screenGridDirty = true;
+}
+
+void PlayerManager::updateScreenGrid()
+{
+    if (screenCapsules.size() != players.size()) // players were added since this frame's projection
+        updateScreenCapsules();
+
+    if (!screenGridDirty)
+        return;
+
+    PROFILE_ZONE("PlayerManager::updateScreenGrid");
+    std::pmr::vector<Rectangle> bounds(screenCapsules.size(), FrameArena::resource());
+    for (size_t i = 0; i < screenCapsules.size(); i++)
+    {
+        const Circle& bottom = screenCapsules[i].bottom;
+        const Circle& top = screenCapsules[i].top;
+        float minX = std::min(bottom.position.x - bottom.radius, top.position.x - top.radius);
+        float minY = std::min(bottom.position.y - bottom.radius, top.position.y - top.radius);
+        float maxX = std::max(bottom.position.x + bottom.radius, top.position.x + top.radius);
+        float maxY = std::max(bottom.position.y + bottom.radius, top.position.y + top.radius);
+        bounds[i] = { minX, minY, maxX - minX, maxY - minY };
+    }
 
-    Circle bottom = cameraManager.convertSphereToCircle(capsule.startPos, capsule.radius);
-    Circle top = cameraManager.convertSphereToCircle(capsule.endPos, capsule.radius);
+    screenGrid.build(bounds, { float(GetScreenWidth()), float(GetScreenHeight()) });
+    screenGridDirty = false;
+}
 
-    bool collisionBottomCircle = CheckCollisionPointCircle(point, bottom.position, bottom.radius);
-    bool collisionTopCircle = CheckCollisionPointCircle(point, top.position, top.radius);
+bool PlayerManager::checkCollisionCapsulePoint(const ScreenCapsule& capsule, Vector2 point)
+{
+    bool collisionBottomCircle = CheckCollisionPointCircle(point, capsule.bottom.position, capsule.bottom.radius);
+    bool collisionTopCircle = CheckCollisionPointCircle(point, capsule.top.position, capsule.top.radius);
 
     // TODO: add collision against cylinder bounding box
     return collisionBottomCircle || collisionTopCircle;
 }
 
-std::vector<Vector3> PlayerManager::pathfindPlayerToPosition(Player* player, Vector3 position)
+bool PlayerManager::checkCollisionCapsuleRec(const ScreenCapsule& capsule, Rectangle rectangle)
+{
+    bool collisionBottomCircle = CheckCollisionCircleRec(capsule.bottom.position, capsule.bottom.radius, rectangle);
+    bool collisionTopCircle = CheckCollisionCircleRec(capsule.top.position, capsule.top.radius, rectangle);
+
+    // TODO: add collision against cylinder bounding box lines
+    return collisionBottomCircle || collisionTopCircle;
+}
+
+Path PlayerManager::findPath(Player* player, Vector3 position)
 {
-    std::vector<Vector3> path = player->playerType == PLAYER_TROLL
+    return player->playerType == PLAYER_TROLL
         ? mapGenerator->pathfindPositionsForTroll(player->getPosition(), position)
         : mapGenerator->pathfindPositionsForElf(player->getPosition(), position);
-    player->setPath(path);
+}
 
-    return path;
+void PlayerManager::requestPath(Player* player, Vector3 position, std::function<void(const Path& path)> onResolved)
+{
+    pathRequests.push_back({ player, position, onResolved });
+}
+
+void PlayerManager::resolvePathRequests()
+{
+    if (pathRequests.empty())
+        return;
+
+    PROFILE_ZONE("PlayerManager::resolvePathRequests");
+    std::vector<PathRequest> requests;
+    requests.swap(pathRequests); // callbacks may request new paths
+
+    std::pmr::vector<Path> paths(requests.size(), FrameArena::resource()); // the paths themselves outlive the tick
+    JobSystem::get().parallelFor(requests.size(), constants::JOB_PATHS_PER_JOB, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            paths[i] = findPath(requests[i].player, requests[i].position);
+    });
+
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        Player* player = requests[i].player;
+        player->setPath(std::move(paths[i]));
+        if (requests[i].onResolved)
+            requests[i].onResolved(player->path);
+    }
 }
 
 Player* PlayerManager::raycastToPlayer()
 {
-    Vector2 mousePos = GetMousePosition();
-    for (Player* player: players)
-        if (checkCollisionCapsulePoint(player->capsule, mousePos))
-            return player;
+    updateScreenGrid();
+
+    Vector2 mousePos = InputManager::get().getMousePosition();
+    for (uint32_t i: screenGrid.query({ mousePos.x, mousePos.y, 0.f, 0.f })) // sorted, the first player still wins
+        if (checkCollisionCapsulePoint(screenCapsules[i], mousePos))
+            return players[i];
 
     return nullptr;
 }
 
+std::vector<Player*> PlayerManager::getPlayersInRectangle(Rectangle rectangle)
+{
+    PROFILE_ZONE("PlayerManager::getPlayersInRectangle");
+    updateScreenGrid();
+
+    std::vector<Player*> hits;
+    for (uint32_t i: screenGrid.query(rectangle))
+        if (checkCollisionCapsuleRec(screenCapsules[i], rectangle))
+            hits.push_back(players[i]);
+
+    return hits;
+}
+
 Player* PlayerManager::getPlayerWithNetworkID(RakNet::NetworkID networkID)
 {
     for (Player* player: players)
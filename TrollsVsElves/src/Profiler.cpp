@@ -0,0 +1,154 @@
+#include "Profiler.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+
+ProfileThread::ProfileThread(uint32_t id)
+{
+    this->name = "thread " + std::to_string(id);
+    this->id = id;
+    this->depth = 0;
+    this->slots = std::vector<ProfileSlot>(CAPACITY);
+    this->written = 0;
+}
+
+void ProfileThread::push(const ProfileEvent& event)
+{
+    // only the owning thread writes, readers use written to know which slots are complete
+    uint64_t index = written.load(std::memory_order_relaxed);
+    ProfileSlot& slot = slots[index % CAPACITY];
+    slot.name.store(event.name, std::memory_order_relaxed);
+    slot.start.store(event.start, std::memory_order_relaxed);
+    slot.end.store(event.end, std::memory_order_relaxed);
+    slot.depth.store(event.depth, std::memory_order_relaxed);
+    written.store(index + 1, std::memory_order_release);
+}
+
+Profiler::Profiler()
+{
+    epoch = std::chrono::steady_clock::now();
+    showOverlay = false;
+    paused = false;
+    pausedAt = 0;
+    statsWindow = 1.f;
+    timelineWindow = 0.05f;
+}
+
+uint64_t Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+ProfileThread& Profiler::getThread()
+{
+    thread_local ProfileThread* thread = nullptr;
+    if (!thread)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        thread = new ProfileThread(threads.size());
+        threads.push_back(thread);
+    }
+
+    return *thread;
+}
+
+void Profiler::setThreadName(std::string name)
+{
+    ProfileThread& thread = getThread();
+    std::lock_guard<std::mutex> lock(mutex); // the name is read by the overlay and the exporter
+    thread.name = name;
+}
+
+std::vector<ProfileThread*> Profiler::getThreads()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return threads;
+}
+
+std::vector<ProfileEvent> Profiler::collect(ProfileThread& thread, uint64_t since)
+{
+    uint64_t end = thread.written.load(std::memory_order_acquire);
+    uint64_t begin = end > ProfileThread::CAPACITY ? end - ProfileThread::CAPACITY : 0;
+
+    std::vector<ProfileEvent> copied;
+    copied.reserve(end - begin);
+    for (uint64_t i = begin; i < end; i++)
+    {
+        const ProfileSlot& slot = thread.slots[i % ProfileThread::CAPACITY];
+        copied.push_back({
+            slot.name.load(std::memory_order_relaxed),
+            slot.start.load(std::memory_order_relaxed),
+            slot.end.load(std::memory_order_relaxed),
+            slot.depth.load(std::memory_order_relaxed)
+        });
+    }
+
+    // the owning thread kept writing while copying, the oldest slots may have been overwritten since,
+    // including the slot it is writing right now
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = thread.written.load(std::memory_order_relaxed);
+    uint64_t firstValid = after >= ProfileThread::CAPACITY ? after - ProfileThread::CAPACITY + 1 : 0;
+    size_t skip = firstValid > begin ? std::min(firstValid - begin, end - begin) : 0;
+
+    std::vector<ProfileEvent> events;
+    events.reserve(copied.size() - skip);
+    for (size_t i = skip; i < copied.size(); i++)
+        if (copied[i].end >= since)
+            events.push_back(copied[i]);
+
+    return events;
+}
+
+bool Profiler::exportChromeTrace(std::string filename)
+{
+    FILE* file = fopen(filename.c_str(), "w");
+    if (!file)
+    {
+        LOG_ERROR("could not open %s for writing", filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    size_t nrOfEvents = 0;
+    for (ProfileThread* thread: getThreads())
+    {
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            name = thread->name;
+        }
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", thread->id, name.c_str());
+        first = false;
+
+        for (const ProfileEvent& event: collect(*thread))
+        {
+            // complete events, timestamps and durations are in microseconds
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                event.name, thread->id, event.start / 1000.0, (event.end - event.start) / 1000.0);
+            nrOfEvents++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    LOG_INFO("exported %zu profiler events to %s", nrOfEvents, filename.c_str());
+    return true;
+}
+
+ProfileZone::ProfileZone(const char* name)
+    : thread(Profiler::get().getThread())
+{
+    this->name = name;
+    this->start = Profiler::get().now();
+    thread.depth++;
+}
+
+ProfileZone::~ProfileZone()
+{
+    thread.depth--;
+    thread.push({ name, start, Profiler::get().now(), thread.depth });
+}
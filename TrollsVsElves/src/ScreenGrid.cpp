@@ -0,0 +1,91 @@
+#include "ScreenGrid.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cmath>
+
+ScreenGrid::ScreenGrid(float cellSize)
+{
+    this->cellSize = cellSize;
+    columns = 0;
+    rows = 0;
+    queryStamp = 0;
+}
+
+void ScreenGrid::getCellRange(Rectangle area, int& minColumn, int& minRow, int& maxColumn, int& maxRow)
+{
+    minColumn = std::clamp(int(std::floor(area.x / cellSize)), 0, columns - 1);
+    minRow = std::clamp(int(std::floor(area.y / cellSize)), 0, rows - 1);
+    maxColumn = std::clamp(int(std::floor((area.x + area.width) / cellSize)), 0, columns - 1);
+    maxRow = std::clamp(int(std::floor((area.y + area.height) / cellSize)), 0, rows - 1);
+}
+
+void ScreenGrid::build(const std::pmr::vector<Rectangle>& bounds, Vector2 screenSize)
+{
+    columns = std::max(1, int(std::ceil(screenSize.x / cellSize)));
+    rows = std::max(1, int(std::ceil(screenSize.y / cellSize)));
+    cellOffsets.assign(columns * rows + 1, 0);
+    queryStamps.assign(bounds.size(), 0);
+    queryStamp = 0;
+
+    Rectangle screen = { 0.f, 0.f, screenSize.x, screenSize.y };
+    int minColumn, minRow, maxColumn, maxRow;
+
+    // count the items per cell, then place them, cells are offset by one so the counts become offsets in place
+    for (const Rectangle& rectangle: bounds)
+    {
+        if (!CheckCollisionRecs(rectangle, screen))
+            continue;
+
+        getCellRange(rectangle, minColumn, minRow, maxColumn, maxRow);
+        for (int row = minRow; row <= maxRow; row++)
+            for (int column = minColumn; column <= maxColumn; column++)
+                cellOffsets[row * columns + column + 1]++;
+    }
+
+    for (size_t i = 1; i < cellOffsets.size(); i++)
+        cellOffsets[i] += cellOffsets[i - 1];
+
+    items.resize(cellOffsets.back());
+    std::pmr::vector<uint32_t> cursors(cellOffsets.begin(), cellOffsets.end() - 1, FrameArena::resource());
+    for (uint32_t i = 0; i < bounds.size(); i++)
+    {
+        if (!CheckCollisionRecs(bounds[i], screen))
+            continue;
+
+        getCellRange(bounds[i], minColumn, minRow, maxColumn, maxRow);
+        for (int row = minRow; row <= maxRow; row++)
+            for (int column = minColumn; column <= maxColumn; column++)
+                items[cursors[row * columns + column]++] = i;
+    }
+}
+
+std::pmr::vector<uint32_t> ScreenGrid::query(Rectangle area)
+{
+    std::pmr::vector<uint32_t> result(FrameArena::resource());
+    if (items.empty())
+        return result;
+
+    queryStamp++;
+    int minColumn, minRow, maxColumn, maxRow;
+    getCellRange(area, minColumn, minRow, maxColumn, maxRow);
+    for (int row = minRow; row <= maxRow; row++)
+    {
+        for (int column = minColumn; column <= maxColumn; column++)
+        {
+            int cell = row * columns + column;
+            for (uint32_t i = cellOffsets[cell]; i < cellOffsets[cell + 1]; i++)
+            {
+                uint32_t item = items[i];
+                if (queryStamps[item] == queryStamp) // spans several cells
+                    continue;
+
+                queryStamps[item] = queryStamp;
+                result.push_back(item);
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,57 @@
+#include "SelectionSet.h"
+
+bool SelectionSet::add(Player* player)
+{
+    if (!indices.emplace(player, members.size()).second)
+        return false;
+
+    members.push_back(player);
+    return true;
+}
+
+bool SelectionSet::remove(Player* player)
+{
+    auto found = indices.find(player);
+    if (found == indices.end())
+        return false;
+
+    // keeps the order, a selection is removed from rarely and front() is the unit whose actions are shown
+    size_t index = found->second;
+    indices.erase(found);
+    members.erase(members.begin() + index);
+    for (size_t i = index; i < members.size(); i++)
+        indices[members[i]] = i;
+
+    return true;
+}
+
+bool SelectionSet::contains(Player* player) const
+{
+    return indices.count(player);
+}
+
+void SelectionSet::clear()
+{
+    members.clear();
+    indices.clear();
+}
+
+size_t SelectionSet::size() const
+{
+    return members.size();
+}
+
+bool SelectionSet::empty() const
+{
+    return members.empty();
+}
+
+Player* SelectionSet::front() const
+{
+    return members.empty() ? nullptr : members.front();
+}
+
+const std::vector<Player*>& SelectionSet::getMembers() const
+{
+    return members;
+}
@@ -0,0 +1,71 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+ThreadPool::ThreadPool(size_t nrOfThreads)
+{
+    unfinished = 0;
+    stopping = false;
+
+    for (size_t i = 0; i < nrOfThreads; i++)
+        workers.push_back(std::thread([this, i]() { work(i); }));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (std::thread& worker: workers)
+        if (worker.joinable())
+            worker.join();
+}
+
+size_t ThreadPool::size()
+{
+    return workers.size();
+}
+
+void ThreadPool::submit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(task);
+        unfinished++;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return unfinished == 0; });
+}
+
+void ThreadPool::work(size_t index)
+{
+    PROFILE_THREAD("worker " + std::to_string(index));
+    (void)index; // unused without the profiler
+
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) // only when stopping
+                return;
+
+            task = tasks.front();
+            tasks.pop();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--unfinished == 0)
+            finished.notify_all();
+    }
+}
@@ -1,6 +1,11 @@
 #include "ThreadSafeMessageQueue.h"
 
-ThreadSafeMessageQueue::ThreadSafeMessageQueue() {}
+#include <algorithm>
+
+ThreadSafeMessageQueue::ThreadSafeMessageQueue()
+{
+    highWaterMark = 0;
+}
 
 ThreadSafeMessageQueue::~ThreadSafeMessageQueue() {}
 
@@ -8,6 +13,7 @@ void ThreadSafeMessageQueue::push(Task task)
 {
     std::lock_guard<std::mutex> lock(mutex);
     messageQueue.push(task);
+    highWaterMark = std::max(highWaterMark, messageQueue.size());
 }
 
 bool ThreadSafeMessageQueue::pop(Task& task)
@@ -20,3 +26,17 @@ bool ThreadSafeMessageQueue::pop(Task& task)
     messageQueue.pop();
     return true;
 }
+
+size_t ThreadSafeMessageQueue::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return messageQueue.size();
+}
+
+size_t ThreadSafeMessageQueue::takeHighWaterMark()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t deepest = highWaterMark;
+    highWaterMark = messageQueue.size();
+    return deepest;
+}
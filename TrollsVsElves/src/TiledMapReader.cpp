@@ -0,0 +1,418 @@
+#include "TiledMapReader.h"
+#include "MapGenerator.h"
+
+#include <zlib.h>
+
+TiledMapReader::TiledMapReader()
+{
+    buffer = std::vector<char>(BUFFER_SIZE);
+    position = 0;
+    end = 0;
+    offset = 0;
+}
+
+int TiledMapReader::peek()
+{
+    if (position == end)
+    {
+        offset += end;
+        file.read(buffer.data(), buffer.size());
+        end = file.gcount();
+        position = 0;
+        if (end == 0)
+            return -1;
+    }
+
+    return (unsigned char)buffer[position];
+}
+
+int TiledMapReader::next()
+{
+    int c = peek();
+    if (c != -1)
+        position++;
+    return c;
+}
+
+void TiledMapReader::skipWhitespace()
+{
+    for (int c = peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t'; c = peek())
+        position++;
+}
+
+bool TiledMapReader::expect(char c)
+{
+    skipWhitespace();
+    if (next() != c)
+        return fail(std::string("expected '") + c + "'");
+    return true;
+}
+
+bool TiledMapReader::fail(std::string message)
+{
+    if (error.empty())
+        error = message + " at byte " + std::to_string(offset + position);
+    return false;
+}
+
+const std::string& TiledMapReader::getError()
+{
+    return error;
+}
+
+bool TiledMapReader::readString(std::string& string)
+{
+    string.clear();
+    if (!expect('"'))
+        return false;
+
+    for (int c = next(); c != '"'; c = next())
+    {
+        if (c == -1)
+            return fail("unterminated string");
+
+        if (c == '\\') // keys and the values read here never need more than the escaped character itself
+        {
+            c = next();
+            if (c == 'u')
+                return fail("unicode escapes are not supported");
+        }
+        string.push_back(char(c));
+    }
+
+    return true;
+}
+
+bool TiledMapReader::readInteger(int64_t& value)
+{
+    skipWhitespace();
+    bool negative = peek() == '-';
+    if (negative)
+        position++;
+
+    if (peek() < '0' || peek() > '9')
+        return fail("expected an integer");
+
+    value = 0;
+    while (peek() >= '0' && peek() <= '9')
+        value = value * 10 + (next() - '0');
+
+    if (peek() == '.' || peek() == 'e' || peek() == 'E')
+        return fail("expected an integer");
+
+    if (negative)
+        value = -value;
+    return true;
+}
+
+bool TiledMapReader::skipValue(int depth)
+{
+    if (depth > 64)
+        return fail("nested too deeply");
+
+    skipWhitespace();
+    int c = peek();
+    if (c == '"')
+    {
+        std::string skipped; // only short strings are skipped, tile data is decoded where it is read
+        return readString(skipped);
+    }
+
+    if (c == '{' || c == '[')
+    {
+        char close = c == '{' ? '}' : ']';
+        position++;
+        skipWhitespace();
+        if (peek() == close)
+        {
+            position++;
+            return true;
+        }
+
+        while (true)
+        {
+            if (c == '{')
+            {
+                std::string key;
+                if (!readString(key) || !expect(':'))
+                    return false;
+            }
+            if (!skipValue(depth + 1))
+                return false;
+
+            skipWhitespace();
+            int separator = next();
+            if (separator == close)
+                return true;
+            if (separator != ',')
+                return fail(std::string("expected ',' or '") + close + "'");
+        }
+    }
+
+    // number, true, false or null
+    bool any = false;
+    for (c = peek(); c != -1 && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\n' && c != '\r' && c != '\t'; c = peek())
+    {
+        position++;
+        any = true;
+    }
+    return any ? true : fail("expected a value");
+}
+
+bool TiledMapReader::read(std::string filename, MapTemplate& mapTemplate)
+{
+    file.open(filename, std::ios::binary);
+    if (!file.is_open())
+        return fail("couldn't open file");
+
+    mapTemplate.gridSize = { 0, 0 };
+    mapTemplate.nrOfLayers = 0;
+    mapTemplate.storage.clear();
+
+    if (!expect('{'))
+        return false;
+
+    // keys come in any order, Tiled writes them alphabetically so the layers are read before the width
+    std::string key;
+    int64_t value;
+    skipWhitespace();
+    bool empty = peek() == '}';
+    while (!empty)
+    {
+        if (!readString(key) || !expect(':'))
+            return false;
+
+        if (key == "width" || key == "height")
+        {
+            if (!readInteger(value))
+                return false;
+            (key == "width" ? mapTemplate.gridSize.x : mapTemplate.gridSize.y) = int(value);
+        }
+        else if (key == "layers")
+        {
+            if (!expect('['))
+                return false;
+
+            skipWhitespace();
+            bool noLayers = peek() == ']';
+            while (!noLayers)
+            {
+                if (!readLayer(mapTemplate))
+                    return false;
+
+                skipWhitespace();
+                int separator = next();
+                if (separator == ']')
+                    break;
+                if (separator != ',')
+                    return fail("expected ',' or ']'");
+            }
+            if (noLayers)
+                position++;
+        }
+        else if (key == "infinite")
+        {
+            skipWhitespace();
+            if (peek() == 't')
+                return fail("infinite maps are not supported");
+            if (!skipValue())
+                return false;
+        }
+        else if (!skipValue())
+            return false;
+
+        skipWhitespace();
+        int separator = next();
+        if (separator == '}')
+            break;
+        if (separator != ',')
+            return fail("expected ',' or '}'");
+    }
+
+    size_t nrOfTiles = size_t(mapTemplate.gridSize.x) * mapTemplate.gridSize.y;
+    if (nrOfTiles == 0)
+        return fail("missing width or height");
+    if (mapTemplate.storage.size() != nrOfTiles * mapTemplate.nrOfLayers)
+        return fail("a layer doesn't have width * height tiles");
+
+    mapTemplate.tiles = mapTemplate.storage.data();
+    return true;
+}
+
+bool TiledMapReader::readLayer(MapTemplate& mapTemplate)
+{
+    if (!expect('{'))
+        return false;
+
+    std::string key;
+    std::string type;
+    std::string compression;
+    std::vector<int32_t> tiles;     // this layer only
+    std::vector<uint8_t> encoded;   // base64 decoded, compressed or not
+    bool hasData = false;
+
+    skipWhitespace();
+    bool empty = peek() == '}';
+    if (empty)
+        position++;
+
+    while (!empty)
+    {
+        if (!readString(key) || !expect(':'))
+            return false;
+
+        if (key == "data")
+        {
+            skipWhitespace();
+            hasData = true;
+            if (peek() == '[' ? !readTileArray(tiles) : !readBase64(encoded))
+                return false;
+        }
+        else if (key == "type")
+        {
+            if (!readString(type))
+                return false;
+        }
+        else if (key == "compression")
+        {
+            if (!readString(compression))
+                return false;
+        }
+        else if (!skipValue()) // including encoding, a string of data is always base64
+            return false;
+
+        skipWhitespace();
+        int separator = next();
+        if (separator == '}')
+            break;
+        if (separator != ',')
+            return fail("expected ',' or '}'");
+    }
+
+    if (!hasData || (type.size() && type != "tilelayer")) // object and image layers, or infinite map chunks
+        return true;
+
+    // compression may come after the data, so compressed data is only inflated once the layer has been read
+    if (encoded.size() && !decodeTiles(encoded, compression, tiles))
+        return false;
+
+    for (int32_t& tile: tiles)
+        tile = int32_t(uint32_t(tile) & ~TILE_FLAGS);
+
+    mapTemplate.storage.insert(mapTemplate.storage.end(), tiles.begin(), tiles.end());
+    mapTemplate.nrOfLayers++;
+    return true;
+}
+
+bool TiledMapReader::readTileArray(std::vector<int32_t>& tiles)
+{
+    if (!expect('['))
+        return false;
+
+    skipWhitespace();
+    if (peek() == ']')
+    {
+        position++;
+        return true;
+    }
+
+    int64_t value;
+    while (true)
+    {
+        if (!readInteger(value))
+            return false;
+        tiles.push_back(int32_t(uint32_t(value)));
+
+        skipWhitespace();
+        int separator = next();
+        if (separator == ']')
+            return true;
+        if (separator != ',')
+            return fail("expected ',' or ']'");
+    }
+}
+
+bool TiledMapReader::readBase64(std::vector<uint8_t>& bytes)
+{
+    if (!expect('"'))
+        return false;
+
+    uint32_t accumulator = 0;
+    int bits = 0;
+    for (int c = next(); c != '"'; c = next())
+    {
+        if (c == -1)
+            return fail("unterminated string");
+        if (c == '\\') // json may escape the slash
+            c = next();
+
+        int sextet;
+        if (c >= 'A' && c <= 'Z')       sextet = c - 'A';
+        else if (c >= 'a' && c <= 'z')  sextet = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')  sextet = c - '0' + 52;
+        else if (c == '+')              sextet = 62;
+        else if (c == '/')              sextet = 63;
+        else if (c == '=' || c == '\n' || c == '\r' || c == ' ') continue;
+        else return fail("invalid base64 data");
+
+        accumulator = (accumulator << 6) | sextet;
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            bytes.push_back(uint8_t(accumulator >> bits));
+        }
+    }
+
+    return true;
+}
+
+bool TiledMapReader::decodeTiles(const std::vector<uint8_t>& bytes, const std::string& compression, std::vector<int32_t>& tiles)
+{
+    // tile ids are little endian 32 bit integers
+    uint8_t partial[4];
+    size_t nrOfPartial = 0;
+    auto append = [&](const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i++)
+        {
+            partial[nrOfPartial++] = data[i];
+            if (nrOfPartial == 4)
+            {
+                tiles.push_back(int32_t(partial[0] | (partial[1] << 8) | (partial[2] << 16) | (uint32_t(partial[3]) << 24)));
+                nrOfPartial = 0;
+            }
+        }
+    };
+
+    if (compression.empty())
+        append(bytes.data(), bytes.size());
+    else if (compression == "zlib" || compression == "gzip")
+    {
+        z_stream stream = {};
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) // + 32 detects either header
+            return fail("couldn't initialize zlib");
+
+        stream.next_in = const_cast<Bytef*>(bytes.data());
+        stream.avail_in = bytes.size();
+
+        uint8_t chunk[16384]; // inflated a chunk at a time straight into the tiles
+        int result = Z_OK;
+        while (result == Z_OK)
+        {
+            stream.next_out = chunk;
+            stream.avail_out = sizeof(chunk);
+            result = inflate(&stream, Z_NO_FLUSH);
+            append(chunk, sizeof(chunk) - stream.avail_out);
+        }
+        inflateEnd(&stream);
+
+        if (result != Z_STREAM_END)
+            return fail("corrupt " + compression + " layer data");
+    }
+    else
+        return fail("unsupported layer compression '" + compression + "'");
+
+    if (nrOfPartial)
+        return fail("layer data isn't a whole number of tiles");
+    return true;
+}
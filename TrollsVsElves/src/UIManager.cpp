@@ -1,5 +1,9 @@
 #include "UIManager.h"
 
+#include <algorithm>
+#include <cinttypes>
+#include <map>
+
 namespace UIManager
 {
     int pushButtonDisabled()
@@ -18,7 +22,7 @@ namespace UIManager
         return 3;
     }
 
-    void drawActionButtons(std::vector<ActionNode>& actions, Vector2i screenSize)
+    void drawActionButtons(const std::vector<ActionNode>& actions, Vector2i screenSize)
     {
         bool bottomRightWindow = true;
         int bottomRightWindowFlags = 0;
@@ -52,15 +56,14 @@ namespace UIManager
         ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, buttonPadding);
 
         size_t buttonsPerLine = buttonLayout.x;
-        ActionNode node;
         bool buttonWasPressed = false;
         for (int i = 0; i < actions.size(); i += buttonsPerLine)
         {
             for (int j = 0; j < buttonsPerLine; j++)
             {
-                node = actions[i+j];
+                const ActionNode& node = actions[i+j];
 
-                if (node.id == "filler") ImGui::InvisibleButton(node.name.c_str(), buttonSize);
+                if (node.type == ACTION_FILLER) ImGui::InvisibleButton(node.name.c_str(), buttonSize);
                 else
                 {
                     int colors = node.promotable ? pushButtonEnabled() : pushButtonDisabled();
@@ -80,7 +83,7 @@ namespace UIManager
 
         if (!buttonWasPressed) // check if any button was clicked using number-key buttons
             for (int i = 0; i < actions.size(); i++)
-                if (IsKeyPressed((KeyboardKey)int(KEY_ONE) + i))
+                if (InputManager::get().isKeyPressed(int(KEY_ONE) + i))
                 {
                     actions[i].callback();
                     break;
@@ -89,4 +92,228 @@ namespace UIManager
         ImGui::PopStyleVar();
         ImGui::End();
     }
-}
\ No newline at end of file
+
+    void drawProfilerTimeline(Profiler& profiler, ProfileThread& thread, uint64_t viewEnd)
+    {
+        const float rowHeight = 18.f;
+        uint64_t span = uint64_t(profiler.timelineWindow * 1e9);
+        uint64_t viewBegin = viewEnd > span ? viewEnd - span : 0;
+
+        std::vector<ProfileEvent> events = profiler.collect(thread, viewBegin);
+        uint32_t maxDepth = 0;
+        for (const ProfileEvent& event: events)
+            maxDepth = std::max(maxDepth, event.depth);
+
+        ImGui::Text("%s", thread.name.c_str());
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        float width = ImGui::GetContentRegionAvail().x;
+        ImGui::Dummy(ImVec2(width, (maxDepth + 1) * rowHeight)); // reserve the area the zones are drawn in
+
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        for (const ProfileEvent& event: events)
+        {
+            if (event.start > viewEnd)
+                continue;
+
+            float x0 = origin.x + width * float(std::max(event.start, viewBegin) - viewBegin) / span;
+            float x1 = origin.x + width * float(std::min(event.end, viewEnd) - viewBegin) / span;
+            x1 = std::max(x1, x0 + 1.f); // keep very short zones visible
+            float y0 = origin.y + event.depth * rowHeight;
+            ImVec2 min(x0, y0), max(x1, y0 + rowHeight - 1.f);
+
+            // same name, same color, across threads and frames
+            float hue = float(std::hash<std::string>()(event.name) % 360) / 360.f;
+            drawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.8f));
+
+            if (ImGui::CalcTextSize(event.name).x < x1 - x0 - 4.f)
+                drawList->AddText(ImVec2(x0 + 2.f, y0 + 2.f), IM_COL32_BLACK, event.name);
+
+            if (ImGui::IsMouseHoveringRect(min, max))
+                ImGui::SetTooltip("%s\n%.3f ms", event.name, (event.end - event.start) / 1e6);
+        }
+    }
+
+    void drawProfiler(Profiler& profiler)
+    {
+        struct ZoneStats
+        {
+            int calls = 0;
+            double total = 0.0; // milliseconds
+            double max = 0.0;
+        };
+
+        if (InputManager::get().isKeyPressed(KEY_F1))
+            profiler.showOverlay = !profiler.showOverlay;
+
+        if (!profiler.showOverlay)
+            return;
+
+        ImGui::SetNextWindowSize(ImVec2(560, 420), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Profiler", &profiler.showOverlay);
+
+        if (ImGui::Checkbox("Pause", &profiler.paused) && profiler.paused)
+            profiler.pausedAt = profiler.now();
+        ImGui::SameLine();
+        if (ImGui::Button("Export Chrome trace"))
+            profiler.exportChromeTrace("profile_trace.json");
+
+        ImGui::SliderFloat("Stats window (s)", &profiler.statsWindow, 0.1f, 5.f);
+        ImGui::SliderFloat("Timeline (s)", &profiler.timelineWindow, 0.005f, 0.5f);
+
+        uint64_t viewEnd = profiler.paused ? profiler.pausedAt : profiler.now();
+        uint64_t statsSpan = uint64_t(profiler.statsWindow * 1e9);
+        uint64_t statsBegin = viewEnd > statsSpan ? viewEnd - statsSpan : 0;
+        std::vector<ProfileThread*> threads = profiler.getThreads();
+
+        // aggregated per zone name over all threads, sorted by name so rows don't jump around
+        std::map<std::string, ZoneStats> zones;
+        for (ProfileThread* thread: threads)
+            for (const ProfileEvent& event: profiler.collect(*thread, statsBegin))
+            {
+                if (event.end > viewEnd)
+                    continue;
+
+                double duration = (event.end - event.start) / 1e6;
+                ZoneStats& stats = zones[event.name];
+                stats.calls++;
+                stats.total += duration;
+                stats.max = std::max(stats.max, duration);
+            }
+
+        int tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+        if (ImGui::BeginTable("zones", 5, tableFlags))
+        {
+            ImGui::TableSetupColumn("zone");
+            ImGui::TableSetupColumn("calls/s");
+            ImGui::TableSetupColumn("avg ms");
+            ImGui::TableSetupColumn("max ms");
+            ImGui::TableSetupColumn("% of time");
+            ImGui::TableHeadersRow();
+
+            for (auto& [name, stats]: zones)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Text("%s", name.c_str());
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%.1f", stats.calls / profiler.statsWindow);
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%.3f", stats.total / stats.calls);
+                ImGui::TableSetColumnIndex(3); ImGui::Text("%.3f", stats.max);
+                ImGui::TableSetColumnIndex(4); ImGui::Text("%.1f", 100.0 * stats.total / (profiler.statsWindow * 1e3));
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::Separator();
+        for (ProfileThread* thread: threads)
+            drawProfilerTimeline(profiler, *thread, viewEnd);
+
+        ImGui::End();
+    }
+
+    void drawNetworkStats(std::function<NetworkStats()> getStats, bool& show)
+    {
+        if (InputManager::get().isKeyPressed(KEY_F2))
+            show = !show;
+
+        if (!show)
+            return;
+
+        NetworkStats stats = getStats();
+
+        ImGui::SetNextWindowSize(ImVec2(640, 360), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Network", &show);
+
+        ImGui::Text("uptime %.0f s", stats.uptime);
+        ImGui::Text("network queue: %zu (max %zu)", stats.networkQueueDepth, stats.networkQueueHighWater);
+        ImGui::Text("game queue: %zu (max %zu)", stats.gameQueueDepth, stats.gameQueueHighWater);
+        ImGui::Text("world: tick %" PRIu64 ", %zu players, %zu buildings", stats.tick, stats.nrOfPlayers, stats.nrOfBuildings);
+        if (stats.conditionerEnabled)
+            ImGui::Text("conditioner: %zu pending, %llu dropped, %llu duplicated, %llu retransmitted",
+                stats.conditionerPending, (unsigned long long)stats.conditionerDropped,
+                (unsigned long long)stats.conditionerDuplicated, (unsigned long long)stats.conditionerRetransmitted);
+
+        int tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+        ImGui::SeparatorText("Connections");
+        if (ImGui::BeginTable("connections", 7, tableFlags))
+        {
+            ImGui::TableSetupColumn("address");
+            ImGui::TableSetupColumn("rtt ms");
+            ImGui::TableSetupColumn("avg/min ms");
+            ImGui::TableSetupColumn("out B/s");
+            ImGui::TableSetupColumn("in B/s");
+            ImGui::TableSetupColumn("resent B (total)");
+            ImGui::TableSetupColumn("loss %");
+            ImGui::TableHeadersRow();
+
+            for (const ConnectionStats& connection: stats.connections)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Text("%s", connection.address.c_str());
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%d", connection.lastPing);
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%d / %d", connection.averagePing, connection.lowestPing);
+                ImGui::TableSetColumnIndex(3); ImGui::Text("%llu", (unsigned long long)connection.bytesSentPerSecond);
+                ImGui::TableSetColumnIndex(4); ImGui::Text("%llu", (unsigned long long)connection.bytesReceivedPerSecond);
+                ImGui::TableSetColumnIndex(5); ImGui::Text("%llu (%llu)", (unsigned long long)connection.bytesResentPerSecond, (unsigned long long)connection.bytesResentTotal);
+                ImGui::TableSetColumnIndex(6); ImGui::Text("%.1f", connection.packetLoss * 100.f);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::SeparatorText("Messages");
+        if (ImGui::BeginTable("messages", 5, tableFlags))
+        {
+            ImGui::TableSetupColumn("id");
+            ImGui::TableSetupColumn("in msgs/s");
+            ImGui::TableSetupColumn("in B (total)");
+            ImGui::TableSetupColumn("out msgs/s");
+            ImGui::TableSetupColumn("out B (total)");
+            ImGui::TableHeadersRow();
+
+            for (const MessageStats& message: stats.messages)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Text("%s (%d)", message.name.c_str(), message.id);
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%.1f", message.messagesInPerSecond);
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%llu", (unsigned long long)message.bytesIn);
+                ImGui::TableSetColumnIndex(3); ImGui::Text("%.1f", message.messagesOutPerSecond);
+                ImGui::TableSetColumnIndex(4); ImGui::Text("%llu", (unsigned long long)message.bytesOut);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::End();
+    }
+
+    void drawCullingStats(const CullingStats& stats, bool& show)
+    {
+        if (InputManager::get().isKeyPressed(KEY_F3))
+            show = !show;
+
+        if (!show)
+            return;
+
+        ImGui::SetNextWindowSize(ImVec2(320, 140), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Rendering", &show);
+
+        int tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+        if (ImGui::BeginTable("culling", 3, tableFlags))
+        {
+            ImGui::TableSetupColumn("");
+            ImGui::TableSetupColumn("submitted");
+            ImGui::TableSetupColumn("culled");
+            ImGui::TableHeadersRow();
+
+            std::pair<const char*, DrawCounts> rows[] = { { "chunks", stats.chunks }, { "buildings", stats.buildings }, { "players", stats.players } };
+            for (auto& [name, counts]: rows)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Text("%s", name);
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%d", counts.submitted);
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%d", counts.culled);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::Text("instanced draw calls: %d", stats.instancedDrawCalls);
+
+        ImGui::End();
+    }
+}
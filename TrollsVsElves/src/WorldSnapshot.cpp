@@ -0,0 +1,38 @@
+#include "WorldSnapshot.h"
+
+#include <thread>
+
+WorldSnapshotBuffer::WorldSnapshotBuffer()
+{
+    readers[0] = 0;
+    readers[1] = 0;
+    front = 0;
+}
+
+WorldSnapshot& WorldSnapshotBuffer::beginPublish()
+{
+    int back = 1 - front.load();
+    while (readers[back].load() > 0) // a reader still holds the snapshot from two publishes ago
+        std::this_thread::yield();
+
+    return snapshots[back];
+}
+
+void WorldSnapshotBuffer::endPublish()
+{
+    front.store(1 - front.load());
+}
+
+WorldSnapshotBuffer::Reader WorldSnapshotBuffer::read()
+{
+    while (true)
+    {
+        // pin the snapshot, then check it is still the front one, else the game thread may be writing it
+        int index = front.load();
+        readers[index].fetch_add(1);
+        if (front.load() == index)
+            return Reader(this, index);
+
+        readers[index].fetch_sub(1);
+    }
+}
@@ -4,7 +4,15 @@
 #include "BaseScreen.h"
 #include "GameScreen.h"
 #include "NetworkManager.h"
-
+#include "MatchHost.h"
+#include "JobSystem.h"
+#include "GameDataBundle.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "UIManager.h"
+
+#include <csignal>
+#include <cstdlib>
 #include <functional>
 #include <string>
 #include <iostream>
@@ -16,9 +24,9 @@ const int SERVER_PORT = 60000;
 
 NetworkType parseNetworkType(int argc, char* argv[])
 {
-    if (argc != 2)
+    if (argc < 2)
     {
-        printf("needs exactly 1 argument\n");
+        LOG_ERROR("needs at least 1 argument");
         exit(0);
     }
 
@@ -27,12 +35,91 @@ NetworkType parseNetworkType(int argc, char* argv[])
     if (type == "client")   return CLIENT;
     if (type == "none")     return NONE;
 
-    printf("expected either 'server', 'client' or 'none' as argument\n");
+    LOG_ERROR("expected either 'server', 'client', 'none' or 'host' as argument");
     exit(0);
 };
 
+// e.g. ./TrollsVsElves client --latency 50 --jitter 10 --loss 2 --duplicate 1 --bandwidth 16000 --workers 3
+ConditionerSettings parseConditionerSettings(int argc, char* argv[])
+{
+    ConditionerSettings settings;
+    for (int i = 2; i < argc; i += 2)
+    {
+        std::string option = std::string(argv[i]);
+        if (i + 1 >= argc)
+        {
+            LOG_ERROR("missing value for %s", option.c_str());
+            exit(0);
+        }
+
+        float value = std::atof(argv[i + 1]);
+        if (option == "--latency")          settings.latency = int(value);          // ms
+        else if (option == "--jitter")      settings.jitter = int(value);           // ms
+        else if (option == "--loss")        settings.loss = value / 100.f;          // percent
+        else if (option == "--duplicate")   settings.duplication = value / 100.f;   // percent
+        else if (option == "--bandwidth")   settings.bandwidth = int(value);        // bytes per second
+        else if (option == "--workers")     JobSystem::get().configure(std::max(0, int(value))); // 0 runs jobs inline
+        else
+        {
+            LOG_ERROR("unknown option %s, expected --latency, --jitter, --loss, --duplicate, --bandwidth or --workers", option.c_str());
+            exit(0);
+        }
+    }
+
+    return settings;
+}
+
+MatchHost* matchHost = nullptr;
+
+// e.g. ./TrollsVsElves host --matches 32 --threads 8 --port 60000 --workers 0
+int runMatchHost(int argc, char* argv[])
+{
+    size_t nrOfMatches = 1;
+    size_t nrOfThreads = std::max(1u, std::thread::hardware_concurrency());
+    int port = SERVER_PORT;
+    for (int i = 2; i < argc; i += 2)
+    {
+        std::string option = std::string(argv[i]);
+        if (i + 1 >= argc)
+        {
+            LOG_ERROR("missing value for %s", option.c_str());
+            exit(0);
+        }
+
+        int value = std::atoi(argv[i + 1]);
+        if (option == "--matches")          nrOfMatches = std::max(1, value);
+        else if (option == "--threads")     nrOfThreads = std::max(1, value);
+        else if (option == "--port")        port = value;
+        else if (option == "--workers")     JobSystem::get().configure(std::max(0, value)); // 0 runs jobs inline
+        else
+        {
+            LOG_ERROR("unknown option %s, expected --matches, --threads, --port or --workers", option.c_str());
+            exit(0);
+        }
+    }
+
+    matchHost = new MatchHost(nrOfMatches, nrOfThreads, port, constants::MATCH_HOST_TICK_RATE);
+    std::signal(SIGINT, [](int) { matchHost->running = false; });
+    std::signal(SIGTERM, [](int) { matchHost->running = false; });
+
+    matchHost->run();
+
+    LOG_INFO("stopping the match host");
+    delete matchHost;
+    matchHost = nullptr;
+    Logger::get().flush();
+
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
+    PROFILE_THREAD("main");
+    GameDataBundle::get().open(constants::GAME_DATA_BUNDLE_FILENAME); // the json files are parsed instead when there is none
+
+    if (argc >= 2 && std::string(argv[1]) == "host")
+        return runMatchHost(argc, argv);
+
     NetworkType type = parseNetworkType(argc, argv);
     bool isSinglePlayer = type == NONE;
 
@@ -45,6 +132,13 @@ int main(int argc, char* argv[])
     NetworkManager networkManager(type, SERVER_PORT, gameScreen);
     gameScreen->networkManager = &networkManager;
 
+    ConditionerSettings conditionerSettings = parseConditionerSettings(argc, argv);
+    networkManager.conditioner.configure(conditionerSettings);
+    if (conditionerSettings.isEnabled())
+        LOG_INFO("network conditioner: latency %d ms, jitter %d ms, loss %.1f%%, duplication %.1f%%, bandwidth %d B/s",
+            conditionerSettings.latency, conditionerSettings.jitter, conditionerSettings.loss * 100.f,
+            conditionerSettings.duplication * 100.f, conditionerSettings.bandwidth);
+
     // SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_VSYNC_HINT | FLAG_WINDOW_RESIZABLE);
     SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_WINDOW_RESIZABLE);
     InitWindow(screenSize.x, screenSize.y, type == SERVER ? "server" : "client");
@@ -55,15 +149,30 @@ int main(int argc, char* argv[])
 
     while (!WindowShouldClose())
     {
-        gameScreen->update();
+        PROFILE_ZONE("frame");
+
+        {
+            PROFILE_ZONE("update");
+            gameScreen->update();
+        }
 
         BeginDrawing();
             ClearBackground(RAYWHITE);
             rlImGuiBegin();
 
-            gameScreen->draw();
+            {
+                PROFILE_ZONE("draw");
+                gameScreen->draw();
+            }
             DrawFPS(0, 0);
 
+#ifdef PROFILER_ENABLED
+            UIManager::drawProfiler(Profiler::get());
+#endif
+            if (type != NONE)
+                UIManager::drawNetworkStats([&networkManager]() { return networkManager.getStats(); }, networkManager.showStatsOverlay);
+            UIManager::drawCullingStats(gameScreen->cullingStats, gameScreen->showCullingStats);
+
             rlImGuiEnd();
         EndDrawing();
     }
@@ -29,6 +29,12 @@ newoption
     default = "opengl33"
 }
 
+newoption
+{
+    trigger = "profiler",
+    description = "record profiler zones in Release builds too, they are always recorded in Debug"
+}
+
 function string.starts(String,Start)
     return string.sub(String,1,string.len(Start))==Start
 end
@@ -83,6 +89,9 @@ workspace (workspaceName)
         defines { "NDEBUG" }
         optimize "On"
 
+    filter "options:profiler"
+        defines { "ENABLE_PROFILER" }
+
     filter { "platforms:x64" }
         architecture "x86_64"
 